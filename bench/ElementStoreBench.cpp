@@ -0,0 +1,160 @@
+/*
+ * Jaoned - an OpenGL & QT based drawing board
+ * Copyright (C) 2024 Vadim Nikolaev (https://github.com/vadniks).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// Compares the old heap-allocated, dynamic_cast-dispatched element stack with ElementStore.
+// Prints one line per measurement: <layout> <operation> <elements> <nanoseconds per element>
+
+#include "ElementStore.hpp"
+#include <QStack>
+#include <QElapsedTimer>
+#include <cstdio>
+
+static const int POINTS_PER_STROKE = 16;
+
+struct LegacyElement { // abstract
+    virtual ~LegacyElement() = default;
+};
+
+struct LegacyPointsSet final : LegacyElement {
+    bool erase;
+    int width;
+    QRgb color;
+    QVector<glm::vec2> points;
+};
+
+struct LegacyLine final : LegacyElement {
+    glm::vec2 start;
+    glm::vec2 end;
+    int width;
+    QRgb color;
+};
+
+struct LegacyText final : LegacyElement {
+    QString text;
+    glm::vec2 pos;
+    int size;
+    QRgb color;
+};
+
+struct LegacyImage final : LegacyElement {
+    glm::vec2 pos;
+    glm::vec2 size;
+};
+
+static volatile float gSink = 0.0f;
+
+static void report(const char* layout, const char* operation, int count, qint64 nanoseconds) {
+    printf("%s %s %d %.2f\n", layout, operation, count, static_cast<double>(nanoseconds) / count);
+}
+
+static void benchLegacy(int count) {
+    QStack<LegacyElement*> elements;
+    const QVector<glm::vec2> points(POINTS_PER_STROKE, glm::vec2(1.0f));
+
+    QElapsedTimer timer;
+    timer.start();
+
+    for (int i = 0; i < count; i++) {
+        switch (i % 4) {
+            case 0: {
+                auto element = new LegacyPointsSet();
+                element->points = points;
+                element->points.detach();
+                elements.push(element);
+            } break;
+            case 1: elements.push(new LegacyLine()); break;
+            case 2: elements.push(new LegacyText()); break;
+            case 3: elements.push(new LegacyImage()); break;
+        }
+    }
+
+    report("legacy", "push", count, timer.nsecsElapsed());
+    timer.restart();
+
+    float sum = 0.0f;
+    for (auto element : elements) {
+        if (auto pointsSet = dynamic_cast<LegacyPointsSet*>(element); pointsSet != nullptr)
+            sum += pointsSet->points.first().x;
+        else if (auto line = dynamic_cast<LegacyLine*>(element); line != nullptr)
+            sum += line->start.x;
+        else if (auto text = dynamic_cast<LegacyText*>(element); text != nullptr)
+            sum += text->pos.x;
+        else if (auto image = dynamic_cast<LegacyImage*>(element); image != nullptr)
+            sum += image->pos.x;
+    }
+    gSink = sum;
+
+    report("legacy", "iterate", count, timer.nsecsElapsed());
+    timer.restart();
+
+    while (!elements.isEmpty())
+        delete elements.pop();
+
+    report("legacy", "undo", count, timer.nsecsElapsed());
+}
+
+static void benchStore(int count) {
+    ElementStore store;
+    const QVector<glm::vec2> points(POINTS_PER_STROKE, glm::vec2(1.0f));
+    const Bounds bounds{glm::vec2(0.0f), glm::vec2(1.0f)};
+
+    QElapsedTimer timer;
+    timer.start();
+
+    for (int i = 0; i < count; i++) {
+        switch (i % 4) {
+            case 0: store.pushPointsSet(false, 1, 0, points.constData(), POINTS_PER_STROKE, nullptr, bounds); break;
+            case 1: store.pushLine(glm::vec2(0.0f), glm::vec2(1.0f), 1, 0, nullptr, bounds); break;
+            case 2: store.pushText(QString(), glm::vec2(0.0f), 1, 0, bounds); break;
+            case 3: store.pushImage(glm::vec2(0.0f), glm::vec2(1.0f), 0, bounds); break;
+        }
+    }
+
+    report("store", "push", count, timer.nsecsElapsed());
+    timer.restart();
+
+    float sum = 0.0f;
+    for (int i = 0; i < store.size(); i++) {
+        const auto& header = store.header(i);
+
+        switch (header.type) {
+            case ElementType::POINTS_SET: sum += store.points(store.pointsSet(header))->x; break;
+            case ElementType::LINE: sum += store.line(header).start.x; break;
+            case ElementType::TEXT: sum += store.text(header).pos.x; break;
+            case ElementType::IMAGE: sum += store.image(header).pos.x; break;
+            case ElementType::ERASURE: break;
+        }
+    }
+    gSink = sum;
+
+    report("store", "iterate", count, timer.nsecsElapsed());
+    timer.restart();
+
+    while (!store.isEmpty())
+        store.pop();
+
+    report("store", "undo", count, timer.nsecsElapsed());
+}
+
+int main() {
+    for (int count : {10000, 100000, 1000000}) {
+        benchLegacy(count);
+        benchStore(count);
+    }
+    return 0;
+}
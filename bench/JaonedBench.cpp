@@ -0,0 +1,357 @@
+/*
+ * Jaoned - an OpenGL & QT based drawing board
+ * Copyright (C) 2024 Vadim Nikolaev (https://github.com/vadniks).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// Renders synthetic boards offscreen through the same painter, tile cache and renderer as the board widget.
+// Prints one JSON object per scenario and mode: frame times in milliseconds, per-frame counters and memory.
+// Usage: JaonedBench [elements] [frames]
+
+#include "Renderer.hpp"
+#include "TileCache.hpp"
+#include "ImageCache.hpp"
+#include "ElementStore.hpp"
+#include "SpatialIndex.hpp"
+#include "ElementPainter.hpp"
+#include <QGuiApplication>
+#include <QOffscreenSurface>
+#include <QOpenGLContext>
+#include <QOpenGLFunctions_3_3_Core>
+#include <QSurfaceFormat>
+#include <QRandomGenerator>
+#include <QElapsedTimer>
+#include <QJsonObject>
+#include <QJsonDocument>
+#include <QFile>
+#include <glm/ext/matrix_clip_space.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+static const int WIDTH = 1280;
+static const int HEIGHT = 720;
+static const int SAMPLES = 4; // as the application requests, for the tiles and the frame they're composited into
+static const int WARMUP_FRAMES = 5;
+static const int STREAM_CHUNK_BYTES = 4 * 1024 * 1024; // between frames, as the board widget does
+static const int POINTS_PER_STROKE = 32;
+static const int DISTINCT_IMAGES = 8;
+static const int IMAGE_SIZE = 256;
+static const quint32 SEED = 0x4a414f4e;
+
+enum class Scenario {STROKES, LINES, TEXT, IMAGES, MIXED};
+enum class Mode {DIRECT, TILES_COLD, TILES_WARM};
+
+static const char* const SCENARIO_NAMES[] = {"strokes", "lines", "text", "images", "mixed"};
+static const char* const MODE_NAMES[] = {"direct", "tilesCold", "tilesWarm"};
+
+static const char* const WORDS[] = {"jaoned", "board", "stroke", "line", "text", "image", "render", "frame"};
+
+// a multisampled frame resolved into a plain one, as the window's framebuffer is when swapped
+struct Target {
+    unsigned framebuffer, renderbuffer;
+    unsigned resolveFramebuffer, resolveRenderbuffer;
+};
+
+struct Board {
+    ElementStore store;
+    SpatialIndex index;
+    QVector<int> images; // handles of the distinct images, held by the board itself
+    QVector<size_t> hashes; // of the distinct images
+};
+
+static glm::vec2 randomPoint(QRandomGenerator& random) {
+    return {
+        static_cast<float>(random.bounded(WIDTH)),
+        static_cast<float>(random.bounded(HEIGHT))
+    };
+}
+
+static QRgb randomColor(QRandomGenerator& random) {
+    return qRgba(random.bounded(256), random.bounded(256), random.bounded(256), 255);
+}
+
+static void pushStroke(Board& board, Renderer& renderer, QRandomGenerator& random) {
+    QVector<glm::vec2> points;
+    points.reserve(POINTS_PER_STROKE);
+    points.push_back(randomPoint(random));
+    for (int i = 1; i < POINTS_PER_STROKE; i++)
+        points.push_back(points.last() + glm::vec2(
+            static_cast<float>(random.bounded(17) - 8),
+            static_cast<float>(random.bounded(17) - 8)
+        ));
+
+    const int width = 2 + random.bounded(9);
+    const int id = board.store.pushPointsSet(false, width, randomColor(random), points.constData(), static_cast<int>(points.size()),
+        renderer.makeStrokeMesh(points), ElementPainter::pointsBounds(points, width));
+    board.index.insert(id, board.store.header(id).bounds);
+}
+
+static void pushLine(Board& board, Renderer& renderer, QRandomGenerator& random) {
+    const auto start = randomPoint(random), end = randomPoint(random);
+    const int width = 1 + random.bounded(8);
+    const int id = board.store.pushLine(start, end, width, randomColor(random),
+        renderer.makeLineMesh(start, end, static_cast<float>(width)), ElementPainter::lineBounds(start, end, width));
+    board.index.insert(id, board.store.header(id).bounds);
+}
+
+static void pushText(Board& board, ElementPainter& painter, QRandomGenerator& random) {
+    QString text;
+    const int words = 2 + random.bounded(6);
+    for (int i = 0; i < words; i++)
+        text += QString(i > 0 ? " " : "") + WORDS[random.bounded(static_cast<int>(sizeof(WORDS) / sizeof(WORDS[0])))];
+
+    const auto pos = randomPoint(random);
+    const int size = 14 + random.bounded(19);
+    const int id = board.store.pushText(text, pos, size, randomColor(random), painter.textBounds(text, pos, size));
+    board.index.insert(id, board.store.header(id).bounds);
+}
+
+static void pushImage(Board& board, ImageCache& imageCache, QRandomGenerator& random) {
+    const int which = random.bounded(static_cast<int>(board.images.size()));
+    const int image = imageCache.acquire(imageCache.image(board.images[which]), board.hashes[which]);
+    const auto pos = randomPoint(random);
+    const auto side = static_cast<float>(64 + random.bounded(IMAGE_SIZE - 63));
+    const glm::vec2 size(side, side);
+
+    const int id = board.store.pushImage(pos, size, image, ElementPainter::imageBounds(pos, size));
+    board.index.insert(id, board.store.header(id).bounds);
+}
+
+static void build(Board& board, Scenario scenario, int count, Renderer& renderer, ImageCache& imageCache, ElementPainter& painter) {
+    QRandomGenerator random(SEED);
+
+    for (int i = 0; i < DISTINCT_IMAGES; i++) {
+        QImage image(IMAGE_SIZE, IMAGE_SIZE, QImage::Format_RGBA8888);
+        image.fill(QColor::fromRgba(randomColor(random)));
+        for (int y = 0; y < IMAGE_SIZE; y += 16)
+            for (int x = (y / 16 % 2) * 16; x < IMAGE_SIZE; x += 32)
+                for (int j = 0; j < 16; j++)
+                    for (int k = 0; k < 16; k++)
+                        image.setPixel(x + k, y + j, randomColor(random));
+        board.hashes.push_back(ImageCache::contentHash(image));
+        board.images.push_back(imageCache.add(image, board.hashes.back(), nullptr));
+    }
+
+    for (int i = 0; i < count; i++) {
+        switch (scenario == Scenario::MIXED ? static_cast<Scenario>(i % 4) : scenario) {
+            case Scenario::STROKES:
+                pushStroke(board, renderer, random);
+                break;
+            case Scenario::LINES:
+                pushLine(board, renderer, random);
+                break;
+            case Scenario::TEXT:
+                pushText(board, painter, random);
+                break;
+            case Scenario::IMAGES:
+                pushImage(board, imageCache, random);
+                break;
+            case Scenario::MIXED:
+                break;
+        }
+    }
+}
+
+static qint64 residentSetBytes() {
+    QFile file("/proc/self/statm");
+    if (!file.open(QIODevice::ReadOnly)) return 0;
+
+    const auto fields = file.readAll().split(' ');
+    return fields.size() > 1 ? fields[1].toLongLong() * 4096 : 0;
+}
+
+static bool makeFramebuffer(QOpenGLFunctions_3_3_Core& gl, int samples, unsigned& framebuffer, unsigned& renderbuffer) {
+    gl.glGenRenderbuffers(1, &renderbuffer);
+    gl.glBindRenderbuffer(GL_RENDERBUFFER, renderbuffer);
+    gl.glRenderbufferStorageMultisample(GL_RENDERBUFFER, samples, GL_RGBA8, WIDTH, HEIGHT);
+    gl.glGenFramebuffers(1, &framebuffer);
+    gl.glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    gl.glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, renderbuffer);
+    return gl.glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+}
+
+static QJsonObject run(QOpenGLFunctions_3_3_Core& gl, const Target& target, Scenario scenario, Mode mode, int count, int frames) {
+    auto renderer = new Renderer(gl);
+    auto tileCache = new TileCache(renderer->state(), SAMPLES, 1.0f);
+    auto imageCache = new ImageCache(renderer->state());
+    auto painter = new ElementPainter(*renderer, *imageCache);
+    auto board = new Board();
+
+    const auto background = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+    const Bounds viewport{glm::vec2(0.0f), glm::vec2(static_cast<float>(WIDTH), static_cast<float>(HEIGHT))};
+    const auto projection = glm::ortho(0.0f, static_cast<float>(WIDTH), static_cast<float>(HEIGHT), 0.0f, -1.0f, 1.0f);
+
+    build(*board, scenario, count, *renderer, *imageCache, *painter);
+
+    auto& state = renderer->state();
+    auto& profiler = renderer->profiler();
+    QVector<double> times;
+    FrameCounters counters{};
+    int painted = 0;
+
+    for (int i = 0; i < WARMUP_FRAMES + frames; i++) {
+        if (mode == Mode::TILES_COLD) tileCache->invalidateAll();
+
+        QElapsedTimer timer;
+        timer.start();
+
+        profiler.beginFrame();
+        const auto frameStart = profiler.now();
+        const auto frame = profiler.begin(ProfilePhase::FRAME);
+
+        gl.glBindFramebuffer(GL_FRAMEBUFFER, target.framebuffer);
+        gl.glViewport(0, 0, WIDTH, HEIGHT);
+        gl.glClearColor(background.r, background.g, background.b, background.a);
+        {
+            ProfileScope scope(profiler, ProfilePhase::CLEAR);
+            gl.glClear(GL_COLOR_BUFFER_BIT);
+        }
+
+        state.beginFrame();
+        imageCache->beginFrame();
+
+        painted = 0;
+        if (mode == Mode::DIRECT) {
+            renderer->setProjection(projection);
+            painted = painter->paint(board->store, board->index, viewport, background, 1.0f);
+        } else {
+            ProfileScope scope(profiler, ProfilePhase::TILES);
+            tileCache->draw(*renderer, viewport, projection, target.framebuffer, background, [&](const Bounds& area) {
+                painted += painter->paint(board->store, board->index, area, background, 1.0f);
+            });
+        }
+
+        gl.glBindFramebuffer(GL_READ_FRAMEBUFFER, target.framebuffer);
+        gl.glBindFramebuffer(GL_DRAW_FRAMEBUFFER, target.resolveFramebuffer);
+        gl.glBlitFramebuffer(0, 0, WIDTH, HEIGHT, 0, 0, WIDTH, HEIGHT, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+
+        imageCache->endFrame();
+        state.endFrame();
+        profiler.end(ProfilePhase::FRAME, frame, frameStart);
+        profiler.endFrame();
+
+        gl.glFinish();
+        const auto elapsed = timer.nsecsElapsed();
+
+        // filtered levels are handed over through the event loop
+        QCoreApplication::processEvents();
+        imageCache->stream(STREAM_CHUNK_BYTES);
+        if (!imageCache->takeStreamed().isEmpty()) tileCache->invalidateAll();
+
+        if (i < WARMUP_FRAMES) continue;
+
+        times.push_back(static_cast<double>(elapsed) / 1e6);
+
+        const auto& last = state.lastFrame();
+        counters.drawCalls += last.drawCalls;
+        counters.bufferBytes += last.bufferBytes;
+        counters.textureUploads += last.textureUploads;
+        counters.textureBytes += last.textureBytes;
+        counters.glyphLoads += last.glyphLoads;
+    }
+
+    std::sort(times.begin(), times.end());
+    double sum = 0.0;
+    for (double i : times)
+        sum += i;
+
+    const auto perFrame = [frames](qint64 value){ return static_cast<double>(value) / frames; };
+    const QJsonObject result{
+        {"scenario", SCENARIO_NAMES[static_cast<int>(scenario)]},
+        {"mode", MODE_NAMES[static_cast<int>(mode)]},
+        {"elements", count},
+        {"frames", frames},
+        {"samples", SAMPLES},
+        {"frameMsMin", times.first()},
+        {"frameMsAvg", sum / static_cast<double>(times.size())},
+        {"frameMsP99", times[std::max(0, static_cast<int>(std::ceil(0.99 * static_cast<double>(times.size()))) - 1)]},
+        {"elementsPainted", painted},
+        {"drawCalls", perFrame(counters.drawCalls)},
+        {"bufferBytes", perFrame(counters.bufferBytes)},
+        {"textureUploads", perFrame(counters.textureUploads)},
+        {"textureUploadBytes", perFrame(counters.textureBytes)},
+        {"glyphLoads", perFrame(counters.glyphLoads)},
+        {"storeBytes", board->store.bytes()},
+        {"pointBytes", board->store.pointArena().reservedBytes()},
+        {"textureBytes", imageCache->residentBytes()},
+        {"tileBytes", static_cast<qint64>(tileCache->tiles()) * TileCache::TILE_SIZE * TileCache::TILE_SIZE * 4},
+        {"residentBytes", residentSetBytes()},
+        {"gpu", profiler.stats()} // microseconds per frame
+    };
+
+    delete board;
+    delete painter;
+    delete imageCache;
+    delete tileCache;
+    delete renderer;
+
+    return result;
+}
+
+int main(int argc, char** argv) {
+    QGuiApplication application(argc, argv);
+
+    const int count = argc > 1 ? QString(argv[1]).toInt() : 1000;
+    const int frames = argc > 2 ? QString(argv[2]).toInt() : 60;
+    if (count <= 0 || frames <= 0) {
+        fprintf(stderr, "usage: %s [elements] [frames]\n", argv[0]);
+        return 1;
+    }
+
+    QSurfaceFormat format;
+    format.setVersion(3, 3);
+    format.setProfile(QSurfaceFormat::OpenGLContextProfile::CoreProfile);
+
+    QOffscreenSurface surface;
+    surface.setFormat(format);
+    surface.create();
+
+    QOpenGLContext context;
+    context.setFormat(format);
+    if (!context.create() || !context.makeCurrent(&surface)) {
+        fprintf(stderr, "no OpenGL 3.3 core context\n");
+        return 1;
+    }
+
+    QOpenGLFunctions_3_3_Core gl;
+    gl.initializeOpenGLFunctions();
+
+    // the surface has no default framebuffer to speak of, frames land in renderbuffers instead
+    Target target{};
+    if (!makeFramebuffer(gl, SAMPLES, target.framebuffer, target.renderbuffer)
+        || !makeFramebuffer(gl, 0, target.resolveFramebuffer, target.resolveRenderbuffer)
+    ) {
+        fprintf(stderr, "incomplete framebuffer\n");
+        return 1;
+    }
+
+    gl.glEnable(GL_MULTISAMPLE);
+
+    for (auto scenario : {Scenario::STROKES, Scenario::LINES, Scenario::TEXT, Scenario::IMAGES, Scenario::MIXED})
+        for (auto mode : {Mode::DIRECT, Mode::TILES_COLD, Mode::TILES_WARM}) {
+            const auto result = run(gl, target, scenario, mode, count, frames);
+            printf("%s\n", QJsonDocument(result).toJson(QJsonDocument::JsonFormat::Compact).constData());
+            fflush(stdout);
+        }
+
+    gl.glDeleteFramebuffers(1, &target.framebuffer);
+    gl.glDeleteRenderbuffers(1, &target.renderbuffer);
+    gl.glDeleteFramebuffers(1, &target.resolveFramebuffer);
+    gl.glDeleteRenderbuffers(1, &target.resolveRenderbuffer);
+    context.doneCurrent();
+
+    return 0;
+}
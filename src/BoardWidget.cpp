@@ -17,66 +17,75 @@
  */
 
 #include "BoardWidget.hpp"
+#include "StrokeSimplifier.hpp"
+#include "Eraser.hpp"
 #include <QKeyEvent>
+#include <QDebug>
+#include <QStandardPaths>
+#include <QSaveFile>
+#include <QJsonDocument>
+#include <algorithm>
+#include <cstring>
 #include <glm/ext/matrix_clip_space.hpp>
 
-struct DrawnElement { // abstract
-protected:
-    DrawnElement() {}
-public:
-    virtual ~DrawnElement() = default;
+// elements being drawn right now, they go to the store once finished
 
-    DISABLE_COPY(DrawnElement)
-    DISABLE_MOVE(DrawnElement)
-};
-
-struct DrawnPointsSet final : public DrawnElement {
+struct DrawnPointsSet final {
     bool erase;
     int width;
     QColor color;
     QVector<glm::vec2> points;
+    StrokeSimplifier simplifier;
 
-    DrawnPointsSet(bool erase, int width, const QColor& color) : erase(erase), width(width), color(color), points() {}
-    ~DrawnPointsSet() override = default;
+    DrawnPointsSet(bool erase, int width, const QColor& color, float tolerance) :
+        erase(erase), width(width), color(color), points(), simplifier(tolerance) {}
 
     DISABLE_COPY(DrawnPointsSet)
     DISABLE_MOVE(DrawnPointsSet)
 };
 
-struct DrawnLine final : public DrawnElement {
+struct DrawnLine final {
     glm::vec2 start;
     glm::vec2 end;
     int width;
     QColor color;
 
     DrawnLine(const glm::vec2& start, const glm::vec2 end, int width, const QColor& color) : start(start), end(end), width(width), color(color) {}
-    ~DrawnLine() override = default;
 
     DISABLE_COPY(DrawnLine)
     DISABLE_MOVE(DrawnLine)
 };
 
-struct DrawnText final : public DrawnElement {
+struct DrawnText final {
     QString text;
     glm::vec2 pos;
     int size;
     QColor color;
 
     DrawnText(const QString& text, const glm::vec2& pos, int size, const QColor& color) : text(text), pos(pos), size(size), color(color) {}
-    ~DrawnText() override = default;
 
     DISABLE_COPY(DrawnText)
     DISABLE_MOVE(DrawnText)
 };
 
-struct DrawnImage final : public DrawnElement {
+struct DrawnImage final {
     glm::vec2 pos;
     glm::vec2 size;
-    Texture* texture;
-
-    DrawnImage(const glm::vec2& pos, const glm::vec2& size, Texture* texture) : pos(pos), size(size), texture(texture) {}
+    Texture* texture; // nullable, absent while decoding or when shared, handed over to the image cache on commit
+    QImage image;
+    size_t hash;
+    int shared; // cache handle of identical pixels already on the board, referenced until commit, or -1
+    int uploadedRows;
+    bool placed;
+
+    DrawnImage(const glm::vec2& pos, const glm::vec2& size) :
+        pos(pos), size(size), texture(nullptr), image(), hash(0), shared(-1), uploadedRows(0), placed(false) {}
+
+    bool uploaded() const {
+        return shared >= 0 || (texture != nullptr && uploadedRows == image.height());
+    }
 
-    ~DrawnImage() override {
+    ~DrawnImage() {
         delete texture;
     }
 
@@ -84,31 +93,106 @@ struct DrawnImage final : public DrawnElement {
     DISABLE_MOVE(DrawnImage)
 };
 
+// journal records of images, the pixels go in once per journal and every use refers to them by content hash
+struct JournalBlob {
+    quint32 width, height;
+    quint64 hash;
+};
+
+struct JournalImage {
+    quint64 hash;
+    float x, y, width, height;
+};
+
+static_assert(sizeof(JournalBlob) == 16 && sizeof(JournalImage) == 24);
+
 BoardWidget::BoardWidget(const std::function<void ()>& parentWidgetModeUpdater) :
     mMode(Mode::DRAW),
     mTheme(Theme::Dark),
     mColor(0xff, 0xff, 0xff),
     mPointWidth(5),
+    mSimplifyTolerance(DEFAULT_SIMPLIFY_TOLERANCE),
+    mCapturedPoints(0),
+    mKeptPoints(0),
+    mStrokes(0),
+    mReportStrokes(qEnvironmentVariableIsSet("JAONED_STROKE_STATS")),
     mProjection(1.0f),
+    mPaintScale(1.0f),
     mRenderer(nullptr),
+    mTileCache(nullptr),
+    mImageCache(nullptr),
+    mPainter(nullptr),
     mOffsetX(0),
     mOffsetY(0),
-    mElements(),
+    mGenerations(),
+    mGeneration(0),
+    mStore(nullptr),
+    mIndex(nullptr),
+    mHistoryBudget(DEFAULT_HISTORY_BUDGET),
     mCurrentPointsSet(nullptr),
+    mStrokeBuffer(),
     mCurrentLine(nullptr),
     mCurrentText(nullptr),
     mCurrentImage(nullptr),
     mDrawCurrentImage(false),
+    mUploadTimer(),
+    mStreamTimer(),
+    mExporter(nullptr),
+    mExportTimer(),
+    mJournal(QStandardPaths::writableLocation(QStandardPaths::StandardLocation::AppDataLocation)),
+    mJournaling(false),
+    mJournaledImages(),
+    mShowStats(false),
+    mStatsTimer(),
+    mElementsPainted(0),
+    mLastElementsPainted(0),
+    mStatsServer(nullptr),
     mParentWidgetModeUpdater(parentWidgetModeUpdater)
 {
     setFocusPolicy(Qt::FocusPolicy::ClickFocus);
+
+    mStrokeBuffer.reserve(STROKE_RESERVE);
+
+    mUploadTimer.setInterval(0);
+    connect(&mUploadTimer, &QTimer::timeout, this, &BoardWidget::uploadImageChunk);
+
+    mStreamTimer.setInterval(0);
+    connect(&mStreamTimer, &QTimer::timeout, this, &BoardWidget::streamImages);
+
+    mExportTimer.setInterval(0);
+    connect(&mExportTimer, &QTimer::timeout, this, &BoardWidget::exportStep);
+
+    mStatsTimer.setInterval(STATS_INTERVAL);
+    connect(&mStatsTimer, &QTimer::timeout, this, [this](){ update(); });
+
+    if (qEnvironmentVariableIsSet("JAONED_STATS_SOCKET"))
+        mStatsServer = new StatsServer(qEnvironmentVariable("JAONED_STATS_SOCKET"), [this](){ return QJsonDocument(stats()).toJson(QJsonDocument::JsonFormat::Compact); });
+
+    mGenerations.push_back({new ElementStore(), new SpatialIndex()});
+    mStore = mGenerations.first().store;
+    mIndex = mGenerations.first().index;
 }
 
 BoardWidget::~BoardWidget() {
-    for (auto i : mElements)
-        delete i;
+    makeCurrent();
 
+    for (const auto& i : mGenerations) {
+        delete i.store;
+        delete i.index;
+    }
+    delete mCurrentPointsSet;
+    delete mCurrentLine;
+    delete mCurrentText;
+    delete mCurrentImage;
+
+    delete mStatsServer;
+    delete mExporter;
+    delete mPainter;
+    delete mImageCache;
+    delete mTileCache;
     delete mRenderer;
+
+    doneCurrent();
 }
 
 QSize BoardWidget::minimumSizeHint() const {
@@ -118,48 +202,86 @@ QSize BoardWidget::minimumSizeHint() const {
 void BoardWidget::initializeGL() {
     QOpenGLFunctions_3_3_Core::initializeOpenGLFunctions();
     mRenderer = new Renderer(*this);
+    mTileCache = new TileCache(mRenderer->state(), format().samples(), static_cast<float>(devicePixelRatioF()));
+    mImageCache = new ImageCache(mRenderer->state());
+    mPainter = new ElementPainter(*mRenderer, *mImageCache);
     updateProjection();
 
     glEnable(GL_MULTISAMPLE);
 
     glViewport(0, 0, 100, 100);
+
+    // the board is rebuilt outside of initialization, which owns the context
+    QTimer::singleShot(0, this, &BoardWidget::restoreJournal);
 }
 
 void BoardWidget::paintGL() {
+    auto& profiler = mRenderer->profiler();
+    profiler.beginFrame();
+    const auto frameStart = profiler.now();
+    const auto frame = profiler.begin(ProfilePhase::FRAME);
+
     if (mTheme == Theme::Dark)
         glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
     else
         glClearColor(1.0f, 1.0f, 1.0f, 1.0f);
 
-    glClear(GL_COLOR_BUFFER_BIT);
-
-    for (auto element : mElements) {
-        if (dynamic_cast<DrawnPointsSet*>(element) != nullptr)
-            paintPointsSet(dynamic_cast<DrawnPointsSet*>(element));
-        else if (dynamic_cast<DrawnLine*>(element) != nullptr)
-            paintLine(dynamic_cast<DrawnLine*>(element));
-        else if (dynamic_cast<DrawnText*>(element) != nullptr)
-            paintText(dynamic_cast<DrawnText*>(element));
-        else if (dynamic_cast<DrawnImage*>(element) != nullptr)
-            paintImage(dynamic_cast<DrawnImage*>(element));
+    {
+        ProfileScope scope(profiler, ProfilePhase::CLEAR);
+        glClear(GL_COLOR_BUFFER_BIT);
     }
 
-    switch (mMode) {
-        case Mode::ERASE:
-            [[gnu::fallthrough]];
-        case Mode::DRAW:
-            paintPointsSet(nullptr);
-            break;
-        case Mode::LINE:
-            paintLine(nullptr);
-            break;
-        case Mode::TEXT:
-            paintText(nullptr);
-            break;
-        case Mode::IMAGE:
-            paintImage(nullptr);
-            break;
+    mRenderer->state().beginFrame();
+    mImageCache->beginFrame();
+
+    const auto xSize = size();
+    const Bounds viewport{
+        glm::vec2(static_cast<float>(mOffsetX), static_cast<float>(mOffsetY)),
+        glm::vec2(static_cast<float>(mOffsetX + xSize.width()), static_cast<float>(mOffsetY + xSize.height()))
+    };
+
+    {
+        ProfileScope scope(profiler, ProfilePhase::TILES);
+        mTileCache->setScale(static_cast<float>(devicePixelRatioF()));
+        mTileCache->draw(*mRenderer, viewport, mProjection, defaultFramebufferObject(), ElementPainter::makeGlColor(themeColor()), [this](const Bounds& area) {
+            paintElements(area);
+        });
+    }
+
+    {
+        ProfileScope scope(profiler, ProfilePhase::CURRENT);
+        switch (mMode) {
+            case Mode::ERASE:
+                [[gnu::fallthrough]];
+            case Mode::DRAW:
+                paintCurrentPointsSet();
+                break;
+            case Mode::LINE:
+                paintCurrentLine();
+                break;
+            case Mode::TEXT:
+                paintCurrentText();
+                break;
+            case Mode::IMAGE:
+                paintCurrentImage();
+                break;
+        }
     }
+
+    {
+        ProfileScope scope(profiler, ProfilePhase::OVERLAY);
+        paintStats();
+    }
+
+    mImageCache->endFrame();
+    mRenderer->state().endFrame();
+    if (mImageCache->streaming() && !mStreamTimer.isActive())
+        mStreamTimer.start();
+    profiler.end(ProfilePhase::FRAME, frame, frameStart);
+    profiler.endFrame();
+
+    mLastElementsPainted = mElementsPainted;
+    mElementsPainted = 0;
 }
 
 void BoardWidget::resizeGL(int w, int h) {
@@ -183,6 +305,16 @@ void BoardWidget::keyPressEvent(QKeyEvent* event) {
         case Qt::Key::Key_Right:
             mOffsetX += step;
             break;
+        case Qt::Key::Key_F3:
+            setStatsVisible(!mShowStats);
+            break;
+        case Qt::Key::Key_F12: {
+            const auto path = qEnvironmentVariableIsSet("JAONED_STATS_FILE")
+                ? qEnvironmentVariable("JAONED_STATS_FILE")
+                : QStandardPaths::writableLocation(QStandardPaths::StandardLocation::AppDataLocation) + "/stats.json";
+            if (!dumpStats(path))
+                qDebug() << "stats: unable to write" << path;
+        } break;
     }
 
     if (mCurrentText != nullptr) {
@@ -192,7 +324,10 @@ void BoardWidget::keyPressEvent(QKeyEvent* event) {
             mCurrentText->text = mCurrentText->text.mid(0, mCurrentText->text.size() - 1);
     }
 
+    makeCurrent();
     updateProjection();
+    doneCurrent();
+
     update();
 }
 
@@ -204,7 +339,7 @@ void BoardWidget::mouseMoveEvent(QMouseEvent* event) {
         case Mode::ERASE:
             [[gnu::fallthrough]];
         case Mode::DRAW:
-            mCurrentPointsSet->points.push_back(glm::vec2(static_cast<float>(x + mOffsetX), static_cast<float>(y + mOffsetY)));
+            mCurrentPointsSet->simplifier.add(mCurrentPointsSet->points, glm::vec2(static_cast<float>(x + mOffsetX), static_cast<float>(y + mOffsetY)));
             break;
         case Mode::LINE:
             mCurrentLine->end.x = static_cast<float>(x + mOffsetX);
@@ -231,8 +366,15 @@ void BoardWidget::mousePressEvent(QMouseEvent* event) {
         case Mode::ERASE:
             [[gnu::fallthrough]];
         case Mode::DRAW:
-            mCurrentPointsSet = new DrawnPointsSet(mMode == Mode::ERASE, mPointWidth, mColor);
-            mCurrentPointsSet->points.push_back(glm::vec2(static_cast<float>(x + mOffsetX), static_cast<float>(y + mOffsetY)));
+            // the board has no zoom yet, so a unit of width is a unit on screen
+            mCurrentPointsSet = new DrawnPointsSet(
+                mMode == Mode::ERASE,
+                mPointWidth,
+                mColor,
+                glm::max(MIN_SIMPLIFY_TOLERANCE, mSimplifyTolerance * static_cast<float>(mPointWidth))
+            );
+            mCurrentPointsSet->points.swap(mStrokeBuffer);
+            mCurrentPointsSet->simplifier.add(mCurrentPointsSet->points, glm::vec2(static_cast<float>(x + mOffsetX), static_cast<float>(y + mOffsetY)));
             break;
         case Mode::LINE:
             {
@@ -257,37 +399,151 @@ void BoardWidget::mousePressEvent(QMouseEvent* event) {
 }
 
 void BoardWidget::mouseReleaseEvent(QMouseEvent*) {
+    makeCurrent();
+
+    // whatever pushes an element discards the redo history first, a release that adds nothing keeps it
     switch (mMode) {
         case Mode::ERASE:
-            [[gnu::fallthrough]];
+            erase(mCurrentPointsSet->points, mCurrentPointsSet->width);
+
+            mCurrentPointsSet->points.clear();
+            mStrokeBuffer.swap(mCurrentPointsSet->points);
+            delete mCurrentPointsSet;
+            mCurrentPointsSet = nullptr;
+            break;
         case Mode::DRAW:
-            mElements.push(mCurrentPointsSet);
+            discardRedo();
+            committed(mStore->pushPointsSet(
+                mCurrentPointsSet->erase,
+                mCurrentPointsSet->width,
+                mCurrentPointsSet->color.rgba(),
+                mCurrentPointsSet->points.constData(),
+                static_cast<int>(mCurrentPointsSet->points.size()),
+                mRenderer->makeStrokeMesh(mCurrentPointsSet->points),
+                ElementPainter::pointsBounds(mCurrentPointsSet->points, mCurrentPointsSet->width)
+            ));
+
+            mStrokes++;
+            mCapturedPoints += mCurrentPointsSet->simplifier.inputCount();
+            mKeptPoints += static_cast<int>(mCurrentPointsSet->points.size());
+
+            if (mReportStrokes)
+                qDebug() << "stroke: captured" << mCurrentPointsSet->simplifier.inputCount()
+                    << "kept" << mCurrentPointsSet->points.size() << "total reduction" << pointReductionRatio();
+
+            mCurrentPointsSet->points.clear();
+            mStrokeBuffer.swap(mCurrentPointsSet->points);
+            delete mCurrentPointsSet;
             mCurrentPointsSet = nullptr;
             break;
         case Mode::LINE:
-            mElements.push(mCurrentLine);
+            discardRedo();
+            committed(mStore->pushLine(
+                mCurrentLine->start,
+                mCurrentLine->end,
+                mCurrentLine->width,
+                mCurrentLine->color.rgba(),
+                mRenderer->makeLineMesh(mCurrentLine->start, mCurrentLine->end, static_cast<float>(mCurrentLine->width)),
+                ElementPainter::lineBounds(mCurrentLine->start, mCurrentLine->end, mCurrentLine->width)
+            ));
+
+            delete mCurrentLine;
             mCurrentLine = nullptr;
             break;
         case Mode::TEXT:
             if (!mCurrentText->text.isEmpty()) {
-                mElements.push(mCurrentText);
-                mCurrentText = nullptr;
-            } else {
-                delete mCurrentText;
-                mCurrentText = nullptr;
+                discardRedo();
+                committed(mStore->pushText(
+                    mCurrentText->text,
+                    mCurrentText->pos,
+                    mCurrentText->size,
+                    mCurrentText->color.rgba(),
+                    mPainter->textBounds(mCurrentText->text, mCurrentText->pos, mCurrentText->size)
+                ));
             }
+
+            delete mCurrentText;
+            mCurrentText = nullptr;
             break;
         case Mode::IMAGE:
-            mDrawCurrentImage = false;
+            // an image still being decoded stays where it was dropped and gets committed once it arrives
+            mCurrentImage->placed = true;
 
-            mElements.push(mCurrentImage);
-            mCurrentImage = nullptr;
-
-            mMode = Mode::DRAW;
-            mParentWidgetModeUpdater();
+            if (mCurrentImage->texture != nullptr || mCurrentImage->shared >= 0) {
+                while (!mCurrentImage->uploaded())
+                    uploadImageRows(mCurrentImage->image.height());
+                commitImage();
+            }
             break;
     }
 
+    doneCurrent();
+
+    update();
+}
+
+void BoardWidget::commitImage() {
+    mDrawCurrentImage = false;
+    discardRedo();
+
+    committed(mStore->pushImage(
+        mCurrentImage->pos,
+        mCurrentImage->size,
+        mCurrentImage->shared >= 0 ? mCurrentImage->shared : mImageCache->add(mCurrentImage->image, mCurrentImage->hash, mCurrentImage->texture),
+        ElementPainter::imageBounds(mCurrentImage->pos, mCurrentImage->size)
+    ));
+
+    mCurrentImage->texture = nullptr;
+    delete mCurrentImage;
+    mCurrentImage = nullptr;
+
+    mMode = Mode::DRAW;
+    mParentWidgetModeUpdater();
+}
+
+void BoardWidget::uploadImageRows(int rows) {
+    const auto& image = mCurrentImage->image;
+    rows = glm::min(rows, image.height() - mCurrentImage->uploadedRows);
+
+    mCurrentImage->texture->update(0, mCurrentImage->uploadedRows, image.width(), rows, image.constScanLine(mCurrentImage->uploadedRows));
+    mCurrentImage->uploadedRows += rows;
+}
+
+void BoardWidget::uploadImageChunk() {
+    if (mCurrentImage == nullptr || mCurrentImage->uploaded()) {
+        mUploadTimer.stop();
+        return;
+    }
+
+    makeCurrent();
+    uploadImageRows(glm::max(1, static_cast<int>(UPLOAD_CHUNK_BYTES / mCurrentImage->image.bytesPerLine())));
+
+    if (mCurrentImage->uploaded()) {
+        mUploadTimer.stop();
+        if (mCurrentImage->placed) commitImage();
+    }
+
+    doneCurrent();
+
+    update();
+}
+
+void BoardWidget::streamImages() {
+    makeCurrent();
+    if (!mImageCache->stream(UPLOAD_CHUNK_BYTES))
+        mStreamTimer.stop();
+    const auto streamed = mImageCache->takeStreamed();
+    doneCurrent();
+
+    if (streamed.isEmpty()) return;
+
+    // their tiles were rasterized from the coarse level
+    for (int i = 0; i < mStore->size(); i++) {
+        const auto& header = mStore->header(i);
+        if (header.type == ElementType::IMAGE && !header.erased && streamed.contains(mStore->image(header).image))
+            mTileCache->invalidate(header.bounds);
+    }
+
     update();
 }
 
@@ -306,110 +562,166 @@ void BoardWidget::updateProjection() {
     mRenderer->setProjection(mProjection);
 }
 
-static glm::vec4 makeGlColor(const QColor& color) {
-    return {
-        static_cast<float>(color.red()) / 255.0f,
-        static_cast<float>(color.green()) / 255.0f,
-        static_cast<float>(color.blue()) / 255.0f,
-        static_cast<float>(color.alpha()) / 255.0f
-    };
-}
+void BoardWidget::committed(int id) {
+    const auto& bounds = mStore->header(id).bounds;
+    mIndex->insert(id, bounds);
+    mTileCache->invalidate(bounds);
+
+    if (!mJournaling) return;
+
+    // the element is copied here and encoded on the journal's thread
+    const auto& header = mStore->header(id);
+    switch (header.type) {
+        case ElementType::POINTS_SET: {
+            const auto& pointsSet = mStore->pointsSet(header);
+            const auto* points = mStore->points(pointsSet);
+
+            mJournal.append(Journal::Operation::COMMIT, [
+                erase = pointsSet.erase,
+                width = pointsSet.width,
+                color = pointsSet.color,
+                points = QVector<glm::vec2>(points, points + pointsSet.pointCount)
+            ](){
+                return Document::pointsSet(erase, width, color, points);
+            });
+        } break;
+        case ElementType::LINE: {
+            const auto& line = mStore->line(header);
+            mJournal.append(Journal::Operation::COMMIT, [start = line.start, end = line.end, width = line.width, color = line.color](){
+                return Document::line(start, end, width, color);
+            });
+        } break;
+        case ElementType::TEXT: {
+            const auto& text = mStore->text(header);
+            mJournal.append(Journal::Operation::COMMIT, [text = text.text, pos = text.pos, size = text.size, color = text.color](){
+                return Document::text(text, pos, size, color);
+            });
+        } break;
+        case ElementType::IMAGE: {
+            const auto& image = mStore->image(header);
+            const auto hash = static_cast<quint64>(mImageCache->hash(image.image));
+
+            if (!mJournaledImages.contains(image.image)) {
+                mJournaledImages.insert(image.image);
+                mJournal.append(Journal::Operation::BLOB, [pixels = mImageCache->image(image.image), hash](){
+                    const JournalBlob blob{static_cast<quint32>(pixels.width()), static_cast<quint32>(pixels.height()), hash};
+
+                    QByteArray data(reinterpret_cast<const char*>(&blob), sizeof(JournalBlob));
+                    data.append(reinterpret_cast<const char*>(pixels.constBits()), pixels.sizeInBytes());
+                    return data;
+                });
+            }
 
-static void blending(bool enable) {
-    if (enable) {
-        glEnable(GL_BLEND);
-        glBlendFunc(GL_SRC_COLOR, GL_ONE_MINUS_SRC_ALPHA);
-    } else {
-        glBlendFunc(GL_SRC_COLOR, GL_ZERO);
-        glDisable(GL_BLEND);
+            const JournalImage record{hash, image.pos.x, image.pos.y, image.size.x, image.size.y};
+            mJournal.append(Journal::Operation::IMAGE, QByteArray(reinterpret_cast<const char*>(&record), sizeof(JournalImage)));
+        } break;
+        case ElementType::ERASURE:
+            break;
     }
 }
 
+void BoardWidget::paintElements(const Bounds& area) {
+    mElementsPainted += mPainter->paint(*mStore, *mIndex, area, ElementPainter::makeGlColor(themeColor()), mPaintScale);
+}
+
 QColor BoardWidget::themeColor() {
     return mTheme == Theme::Dark ? QColor(0, 0, 0) : QColor(0xff, 0xff, 0xff);
 }
 
-void BoardWidget::paintPointsSet(DrawnPointsSet* /*nullable*/ pointsSet) {
-    if (pointsSet != nullptr) {
-        int j = 0;
-        for (const auto& i : pointsSet->points) {
-            if (j < pointsSet->points.size() - 1) {
-                const auto startPos = glm::vec2(static_cast<float>(i.x), static_cast<float>(i.y));
-                const auto endPos = glm::vec2(static_cast<float>(pointsSet->points.operator[](j + 1).x), static_cast<float>(pointsSet->points.operator[](j + 1).y));
-                const auto color = makeGlColor(pointsSet->erase ? themeColor() : pointsSet->color);
-                const auto width = static_cast<float>(pointsSet->width);
+void BoardWidget::paintStats() {
+    if (!mShowStats) return;
 
-                mRenderer->drawLine(startPos, endPos, width, color);
-                mRenderer->drawPoint(startPos, width * 0.7f, color);
-                mRenderer->drawHollowCircle(startPos, static_cast<int>(width / 2.0f), color);
-            }
-            j++;
-        }
-    } else {
-        if (mCurrentPointsSet == nullptr) return;
-        for (const auto& i : mCurrentPointsSet->points) {
-            const auto pos = glm::vec2(static_cast<float>(i.x), static_cast<float>(i.y));
-            const auto color = makeGlColor(mCurrentPointsSet->erase ? themeColor() : mCurrentPointsSet->color);
-
-            mRenderer->drawPoint(pos, static_cast<float>(mCurrentPointsSet->width) * 0.7f, color);
-            mRenderer->drawHollowCircle(pos, static_cast<int>(static_cast<float>(mCurrentPointsSet->width) / 2.0f), color);
-        }
-    }
+    ElementPainter::blending(mRenderer->state(), true);
+    const auto color = ElementPainter::makeGlColor(mTheme == Theme::Dark ? QColor(0xff, 0xff, 0xff) : QColor(0, 0, 0));
+    const auto all = stats();
+
+    // a line per group and per nested group, keys as they come
+    glm::vec2 pos(static_cast<float>(mOffsetX + STATS_TEXT_SIZE), static_cast<float>(mOffsetY + STATS_TEXT_SIZE));
+    std::function<void(const QString&, const QJsonObject&)> paintGroup = [&](const QString& name, const QJsonObject& values) {
+        auto line = name + ":";
+        for (auto i = values.constBegin(); i != values.constEnd(); i++)
+            if (!i.value().isObject())
+                line += " " + i.key() + " " + i.value().toVariant().toString();
+
+        mRenderer->drawText(line, STATS_TEXT_SIZE, pos, color);
+        pos.y += static_cast<float>(STATS_TEXT_SIZE) * 1.5f;
+
+        for (auto i = values.constBegin(); i != values.constEnd(); i++)
+            if (i.value().isObject())
+                paintGroup(name + "." + i.key(), i.value().toObject());
+    };
+
+    for (auto group = all.constBegin(); group != all.constEnd(); group++)
+        paintGroup(group.key(), group.value().toObject());
 }
 
-void BoardWidget::paintLine(DrawnLine* /*nullable*/ line) {
-    if (line == nullptr)
-        line = mCurrentLine;
-    if (line == nullptr)
-        return;
+void BoardWidget::paintCurrentPointsSet() {
+    if (mCurrentPointsSet == nullptr) return;
+    ElementPainter::blending(mRenderer->state(), false);
 
-    const auto startPos = glm::vec2(static_cast<float>(line->start.x), static_cast<float>(line->start.y));
-    const auto endPos = glm::vec2(static_cast<float>(line->end.x), static_cast<float>(line->end.y));
-    mRenderer->drawLine(startPos, endPos, static_cast<float>(line->width), makeGlColor(line->color));
-}
-
-void BoardWidget::paintText(DrawnText* /*nullable*/ text) {
-    blending(true);
-
-    if (text != nullptr)
-        mRenderer->drawText(text->text, text->size, text->pos, makeGlColor(text->color));
-    else if (mCurrentText != nullptr) {
-        const auto textSize = mRenderer->textMetrics(mCurrentText->text, mCurrentText->size);
-        const auto textHeight = textSize.height() > mCurrentText->size ? textSize.height() : mCurrentText->size;
-        const auto textWidth = textSize.width() > 20 ? textSize.width() : 20;
-
-        const auto color = makeGlColor(mCurrentText->color);
-
-        mRenderer->drawLine(
-            mCurrentText->pos,
-            mCurrentText->pos + glm::vec2(0.0f, static_cast<float>(textHeight)),
-            1.0f,
-            color
-        );
-        mRenderer->drawLine(
-            mCurrentText->pos + glm::vec2(0.0f, static_cast<float>(textHeight)),
-            mCurrentText->pos + glm::vec2(static_cast<float>(textWidth), static_cast<float>(textHeight)),
-            1.0f,
-            color
-        );
-
-        mRenderer->drawText(mCurrentText->text, mCurrentText->size, mCurrentText->pos, color);
-    }
+    mRenderer->drawStroke(
+        mCurrentPointsSet->points,
+        static_cast<float>(mCurrentPointsSet->width),
+        ElementPainter::makeGlColor(mCurrentPointsSet->erase ? themeColor() : mCurrentPointsSet->color)
+    );
+}
+
+void BoardWidget::paintCurrentLine() {
+    if (mCurrentLine == nullptr) return;
+    ElementPainter::blending(mRenderer->state(), false);
+    mRenderer->drawLine(mCurrentLine->start, mCurrentLine->end, static_cast<float>(mCurrentLine->width), ElementPainter::makeGlColor(mCurrentLine->color));
+}
+
+void BoardWidget::paintCurrentText() {
+    if (mCurrentText == nullptr) return;
+    ElementPainter::blending(mRenderer->state(), true);
+
+    const auto textSize = mRenderer->textMetrics(mCurrentText->text, mCurrentText->size);
+    const auto textHeight = textSize.height() > mCurrentText->size ? textSize.height() : mCurrentText->size;
+    const auto textWidth = textSize.width() > 20 ? textSize.width() : 20;
 
-    blending(false);
+    const auto color = ElementPainter::makeGlColor(mCurrentText->color);
+
+    mRenderer->drawLine(
+        mCurrentText->pos,
+        mCurrentText->pos + glm::vec2(0.0f, static_cast<float>(textHeight)),
+        1.0f,
+        color
+    );
+    mRenderer->drawLine(
+        mCurrentText->pos + glm::vec2(0.0f, static_cast<float>(textHeight)),
+        mCurrentText->pos + glm::vec2(static_cast<float>(textWidth), static_cast<float>(textHeight)),
+        1.0f,
+        color
+    );
+
+    mRenderer->drawText(mCurrentText->text, mCurrentText->size, mCurrentText->pos, color);
 }
 
-void BoardWidget::paintImage(DrawnImage* /*nullable*/ image) {
-    blending(true);
+void BoardWidget::paintCurrentImage() {
+    if (!mDrawCurrentImage) return;
+    ElementPainter::blending(mRenderer->state(), true);
 
-    if (image != nullptr)
-        mRenderer->drawTexture(*(image->texture), image->pos, image->size, 0.0f, glm::vec4(1.0f));
-    else if (mDrawCurrentImage) {
-        assert(mCurrentImage != nullptr);
-        mRenderer->drawTexture(*(mCurrentImage->texture), mCurrentImage->pos, mCurrentImage->size, 0.0f, glm::vec4(1.0f));
+    assert(mCurrentImage != nullptr);
+
+    if (mCurrentImage->uploaded()) {
+        auto& texture = mCurrentImage->shared >= 0
+            ? mImageCache->texture(mCurrentImage->shared, mCurrentImage->size)
+            : *(mCurrentImage->texture);
+        mRenderer->drawTexture(texture, mCurrentImage->pos, mCurrentImage->size, 0.0f, glm::vec4(1.0f));
+        return;
     }
 
-    blending(false);
+    // placeholder frame while the image is decoded and uploaded
+    const auto color = ElementPainter::makeGlColor(mColor);
+    const auto& pos = mCurrentImage->pos;
+    const auto& size = mCurrentImage->size;
+
+    mRenderer->drawLine(pos, pos + glm::vec2(size.x, 0.0f), 1.0f, color);
+    mRenderer->drawLine(pos + glm::vec2(size.x, 0.0f), pos + size, 1.0f, color);
+    mRenderer->drawLine(pos + size, pos + glm::vec2(0.0f, size.y), 1.0f, color);
+    mRenderer->drawLine(pos + glm::vec2(0.0f, size.y), pos, 1.0f, color);
+    mRenderer->drawLine(pos, pos + size, 1.0f, color);
 }
 
 void BoardWidget::setMode(Mode mode) {
@@ -418,6 +730,7 @@ void BoardWidget::setMode(Mode mode) {
 
 void BoardWidget::setTheme(Theme theme) {
     mTheme = theme;
+    mTileCache->invalidateAll();
     update();
 }
 
@@ -430,23 +743,505 @@ void BoardWidget::setPointWidth(int width) {
     mPointWidth = width;
 }
 
-void BoardWidget::setCurrentTexture(const glm::vec2& size, const uchar* data) {
-    auto* texture = new Texture(*this, static_cast<int>(size.x), static_cast<int>(size.y), data);
-    mCurrentImage = new DrawnImage(glm::vec2(0.0f), size, texture);
+void BoardWidget::setSimplifyTolerance(float tolerance) {
+    assert(tolerance >= 0.0f);
+    mSimplifyTolerance = tolerance;
+}
+
+void BoardWidget::setTextureBudget(qint64 bytes) {
+    mImageCache->setBudget(bytes);
+    update();
+}
+
+qint64 BoardWidget::residentTextureBytes() const {
+    return mImageCache->residentBytes();
+}
+
+QJsonObject BoardWidget::stats() const {
+    if (mRenderer == nullptr) return {};
+
+    const auto& state = mRenderer->state();
+    const auto& frame = state.lastFrame();
+    const auto& points = mStore->pointArena();
+
+    return {
+        {"frame", QJsonObject{
+            {"drawCalls", frame.drawCalls},
+            {"bufferBytes", frame.bufferBytes},
+            {"textureUploads", frame.textureUploads},
+            {"textureUploadBytes", frame.textureBytes},
+            {"glyphLoads", frame.glyphLoads},
+            {"stateCalls", state.issuedCalls()},
+            {"skippedStateCalls", state.skippedCalls()},
+            {"elementsDrawn", mLastElementsPainted}
+        }},
+        {"elements", QJsonObject{
+            {"visible", mStore->size()},
+            {"indexed", mIndex->size()},
+            {"bytes", mStore->bytes()},
+            {"pointBytes", points.usedBytes()},
+            {"pointBytesReserved", points.reservedBytes()},
+            {"historyBytes", historyBytes()}
+        }},
+        {"strokes", QJsonObject{
+            {"committed", mStrokes},
+            {"pointsPerStroke", mStrokes > 0 ? static_cast<double>(mKeptPoints) / mStrokes : 0.0},
+            {"pointReduction", static_cast<double>(pointReductionRatio())}
+        }},
+        {"textures", QJsonObject{
+            {"residentBytes", mImageCache->residentBytes()},
+            {"budgetBytes", mImageCache->budget()}
+        }},
+        {"gpu", mRenderer->profiler().stats()} // microseconds per frame
+    };
+}
+
+qint64 BoardWidget::historyBytes() const {
+    qint64 bytes = mStore->hiddenBytes();
+    for (int i = 0; i < mGenerations.size(); i++)
+        if (i != mGeneration) bytes += mGenerations[i].store->bytes();
+    return bytes;
+}
+
+void BoardWidget::beginImage(const glm::vec2& size) {
+    discardImage();
+
+    mCurrentImage = new DrawnImage(glm::vec2(0.0f), size);
+    mDrawCurrentImage = false;
+}
+
+void BoardWidget::setCurrentImage(const QImage& image, size_t hash) {
+    assert(mCurrentImage != nullptr && mCurrentImage->texture == nullptr && mCurrentImage->shared < 0);
+    assert(image.format() == QImage::Format::Format_RGBA8888);
+
+    mCurrentImage->size = glm::vec2(static_cast<float>(image.width()), static_cast<float>(image.height()));
+    mCurrentImage->image = image;
+    mCurrentImage->hash = hash;
+    mCurrentImage->uploadedRows = 0;
+
+    // pixels already on the board are reused as they are, with nothing to upload
+    makeCurrent();
+    mCurrentImage->shared = mImageCache->acquire(image, hash);
+    if (mCurrentImage->shared >= 0) {
+        // committing may discard redo, which deletes GL objects
+        if (mCurrentImage->placed) commitImage();
+        doneCurrent();
+        update();
+        return;
+    }
+
+    mCurrentImage->texture = new Texture(mRenderer->state(), image.width(), image.height(), nullptr);
+    doneCurrent();
+
+    mUploadTimer.start();
+}
+
+void BoardWidget::discardImage() {
+    mUploadTimer.stop();
+    if (mCurrentImage == nullptr) return;
+
+    makeCurrent();
+    if (mCurrentImage->shared >= 0)
+        mImageCache->remove(mCurrentImage->shared);
+    delete mCurrentImage;
+    doneCurrent();
+
+    mCurrentImage = nullptr;
+}
+
+void BoardWidget::cancelImage() {
+    discardImage();
+
+    mDrawCurrentImage = false;
+    mMode = Mode::DRAW;
+    mParentWidgetModeUpdater();
+
+    update();
+}
+
+void BoardWidget::setStatsVisible(bool visible) {
+    mShowStats = visible;
+
+    // the counters only move while something is drawn, so the overlay keeps frames coming
+    if (visible)
+        mStatsTimer.start();
+    else
+        mStatsTimer.stop();
+
+    update();
+}
+
+void BoardWidget::setHistoryBudget(qint64 bytes) {
+    assert(bytes >= 0);
+    mHistoryBudget = bytes;
+
+    makeCurrent();
+    trimHistory();
+    doneCurrent();
 }
 
 void BoardWidget::undo() {
-    if (mElements.isEmpty()) return;
+    // elements stay stored for redo, only their tiles change
+    if (!mStore->isEmpty()) {
+        bool joined = true;
+        while (joined) {
+            const int id = mStore->size() - 1;
+            joined = mStore->header(id).joined;
+            shown(id, false);
+            mStore->hide();
+        }
+    } else if (mGeneration > 0)
+        setGeneration(mGeneration - 1);
+    else
+        return;
+
+    makeCurrent();
+    trimHistory();
+    doneCurrent();
+
+    if (mJournaling) mJournal.append(Journal::Operation::UNDO);
+
+    update();
+}
+
+void BoardWidget::redo() {
+    // elements undone in this generation come back before the clear that was undone to reach it
+    if (mStore->hiddenCount() > 0) {
+        do {
+            mStore->show();
+            shown(mStore->size() - 1, true);
+        } while (mStore->hiddenCount() > 0 && mStore->header(mStore->size()).joined);
+    } else if (mGeneration + 1 < mGenerations.size())
+        setGeneration(mGeneration + 1);
+    else
+        return;
+
+    if (mJournaling) mJournal.append(Journal::Operation::REDO);
 
-    delete mElements.pop();
     update();
 }
 
 void BoardWidget::clear() {
-    for (auto i : mElements)
-        delete i;
+    if (mStore->isEmpty()) return;
+
+    // the cleared board is kept whole as the generation below, so clearing and undoing it cost the same
+    makeCurrent();
+    discardRedo();
+    mGenerations.push_back({new ElementStore(), new SpatialIndex()});
+    setGeneration(mGeneration + 1);
+    trimHistory();
+    doneCurrent();
+
+    if (mJournaling) mJournal.append(Journal::Operation::CLEAR);
+
+    update();
+}
+
+bool BoardWidget::saveDocument(const QString& path) const {
+    return Document::save(path, *mStore, *mImageCache);
+}
+
+bool BoardWidget::dumpStats(const QString& path) const {
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) return false;
+
+    file.write(QJsonDocument(stats()).toJson());
+    return file.commit();
+}
+
+bool BoardWidget::openDocument(const QString& path) {
+    const bool journaling = mJournaling;
+    mJournaling = false;
+
+    reset();
+    const bool success = appendDocument([&path](const DocumentVisitor& visitor){ return Document::load(path, visitor); });
+    if (!success) reset();
 
-    mElements.clear();
+    // the opened board is where the journal continues from
+    compactJournal();
+    mJournaling = journaling;
+
+    update();
+    return success;
+}
+
+bool BoardWidget::appendDocument(const std::function<bool (const DocumentVisitor& visitor)>& read) {
+    QVector<int> blobImages; // handles, each acquired once by the blob and once more by every image using it
+    QVector<size_t> blobHashes;
+    makeCurrent();
+    discardRedo();
+
+    const bool success = read({
+        [this, &blobImages, &blobHashes](int, const QImage& image) {
+            blobHashes.push_back(ImageCache::contentHash(image));
+            blobImages.push_back(mImageCache->add(image, blobHashes.back(), nullptr));
+        },
+        [this](bool erase, int width, QRgb color, const QVector<glm::vec2>& points) {
+            committed(mStore->pushPointsSet(erase, width, color, points.constData(), static_cast<int>(points.size()),
+                mRenderer->makeStrokeMesh(points), ElementPainter::pointsBounds(points, width)));
+        },
+        [this](const glm::vec2& start, const glm::vec2& end, int width, QRgb color) {
+            committed(mStore->pushLine(start, end, width, color,
+                mRenderer->makeLineMesh(start, end, static_cast<float>(width)), ElementPainter::lineBounds(start, end, width)));
+        },
+        [this](const QString& text, const glm::vec2& pos, int size, QRgb color) {
+            committed(mStore->pushText(text, pos, size, color, mPainter->textBounds(text, pos, size)));
+        },
+        [this, &blobImages, &blobHashes](const glm::vec2& pos, const glm::vec2& size, int blob) {
+            const int image = mImageCache->acquire(mImageCache->image(blobImages[blob]), blobHashes[blob]);
+            committed(mStore->pushImage(pos, size, image, ElementPainter::imageBounds(pos, size)));
+        }
+    });
+
+    for (int i : blobImages)
+        mImageCache->remove(i);
+
+    doneCurrent();
+    return success;
+}
+
+void BoardWidget::erase(const QVector<glm::vec2>& path, int width) {
+    const Eraser eraser(path, static_cast<float>(width));
+    const auto area = ElementPainter::pointsBounds(path, width);
+
+    QVector<int> targets;
+    QVector<QVector<glm::vec2>> runs;
+    QVector<int> runEnds; // of every target in runs
+    auto bounds = area;
+
+    for (int i : mIndex->query(area)) {
+        const auto& header = mStore->header(i);
+
+        if (header.type == ElementType::POINTS_SET) {
+            const auto& pointsSet = mStore->pointsSet(header);
+            if (pointsSet.erase || !eraser.cut(mStore->points(pointsSet), pointsSet.pointCount, static_cast<float>(pointsSet.width), runs)) continue;
+        } else if (header.type == ElementType::LINE) {
+            const auto& line = mStore->line(header);
+            const glm::vec2 points[] = {line.start, line.end};
+            if (!eraser.cut(points, 2, static_cast<float>(line.width), runs)) continue;
+        } else
+            continue;
+
+        targets.push_back(i);
+        runEnds.push_back(static_cast<int>(runs.size()));
+        bounds = bounds.united(header.bounds);
+    }
+
+    if (targets.isEmpty()) return;
+
+    // the erasure goes first and what's left of its targets is joined above it, so it's all undone at once
+    discardRedo();
+    mStore->pushErasure(targets, bounds);
+
+    int run = 0;
+    for (int i = 0; i < targets.size(); i++) {
+        mIndex->remove(targets[i]);
+
+        // copies, pushing may move the store's arrays
+        const auto header = mStore->header(targets[i]);
+        const auto pointsSet = header.type == ElementType::POINTS_SET ? mStore->pointsSet(header) : PointsSetElement{};
+        const auto line = header.type == ElementType::LINE ? mStore->line(header) : LineElement{};
+
+        for (; run < runEnds[i]; run++) {
+            const auto& points = runs[run];
+            const int id = header.type == ElementType::POINTS_SET
+                ? mStore->pushPointsSet(false, pointsSet.width, pointsSet.color, points.constData(), static_cast<int>(points.size()),
+                    mRenderer->makeStrokeMesh(points), ElementPainter::pointsBounds(points, pointsSet.width))
+                : mStore->pushLine(points.first(), points.last(), line.width, line.color,
+                    mRenderer->makeLineMesh(points.first(), points.last(), static_cast<float>(line.width)), ElementPainter::lineBounds(points.first(), points.last(), line.width));
+
+            mStore->join(id, header.z);
+            mIndex->insert(id, mStore->header(id).bounds);
+        }
+    }
+
+    mTileCache->invalidate(bounds);
+
+    if (!mJournaling) return;
+
+    QByteArray data;
+    data.append(reinterpret_cast<const char*>(&width), sizeof(int));
+    data.append(reinterpret_cast<const char*>(path.constData()), static_cast<qsizetype>(path.size() * sizeof(glm::vec2)));
+    mJournal.append(Journal::Operation::ERASE, data);
+}
+
+void BoardWidget::shown(int id, bool visible) {
+    const auto& header = mStore->header(id);
+
+    if (header.type == ElementType::ERASURE) {
+        const auto& erasure = mStore->erasure(header);
+        const int* targets = mStore->targets(erasure);
+        for (int i = 0; i < erasure.targetCount; i++) {
+            if (visible)
+                mIndex->remove(targets[i]);
+            else
+                mIndex->insert(targets[i], mStore->header(targets[i]).bounds);
+        }
+    } else if (visible)
+        mIndex->insert(id, header.bounds);
+    else
+        mIndex->remove(id);
+
+    mTileCache->invalidate(header.bounds);
+}
+
+void BoardWidget::setGeneration(int generation) {
+    mGeneration = generation;
+    mStore = mGenerations[generation].store;
+    mIndex = mGenerations[generation].index;
+    mTileCache->invalidateAll();
+}
+
+void BoardWidget::deleteGeneration(const Generation& generation) {
+    while (generation.store->size() + generation.store->hiddenCount() > 0)
+        dropTop(*generation.store);
+
+    delete generation.store;
+    delete generation.index;
+}
+
+void BoardWidget::dropTop(ElementStore& store) {
+    const auto& header = store.header(store.size() + store.hiddenCount() - 1);
+    if (header.type == ElementType::IMAGE)
+        mImageCache->remove(store.image(header).image);
+    store.pop();
+}
+
+void BoardWidget::dropTopUnit(ElementStore& store) {
+    // an erasure comes back with all of its pieces or not at all, half of them would leave strokes cut short
+    bool joined = true;
+    while (joined) {
+        joined = store.header(store.size() + store.hiddenCount() - 1).joined;
+        dropTop(store);
+    }
+}
+
+void BoardWidget::discardRedo() {
+    while (mStore->hiddenCount() > 0)
+        dropTop(*mStore);
+
+    while (mGenerations.size() > mGeneration + 1) {
+        deleteGeneration(mGenerations.last());
+        mGenerations.removeLast();
+    }
+}
+
+void BoardWidget::trimHistory() {
+    // cleared boards go oldest first, then undone elements in the order they were undone
+    while (historyBytes() > mHistoryBudget) {
+        if (mGeneration > 0) {
+            deleteGeneration(mGenerations.first());
+            mGenerations.removeFirst();
+            mGeneration--;
+        } else if (mGenerations.size() > mGeneration + 1) {
+            const auto& last = mGenerations.last();
+            if (last.store->hiddenCount() > 0)
+                dropTopUnit(*last.store);
+            else {
+                deleteGeneration(last);
+                mGenerations.removeLast();
+            }
+        } else if (mStore->hiddenCount() > 0)
+            dropTopUnit(*mStore);
+        else
+            break;
+    }
+}
+
+void BoardWidget::reset() {
+    makeCurrent();
+
+    for (const auto& i : mGenerations)
+        deleteGeneration(i);
+    mGenerations.clear();
+    mImageCache->clear();
+
+    mGenerations.push_back({new ElementStore(), new SpatialIndex()});
+    setGeneration(0);
+
+    doneCurrent();
+}
+
+void BoardWidget::compactJournal() {
+    if (mJournal.rotate([this](const QString& snapshot){ return Document::save(snapshot, *mStore, *mImageCache); }))
+        mJournaledImages.clear();
+}
+
+void BoardWidget::restoreJournal() {
+    QHash<quint64, QImage> blobs; // of the journal, by content hash
+
+    const bool success = mJournal.replay(
+        [this](const QString& snapshot){
+            return appendDocument([&snapshot](const DocumentVisitor& visitor){ return Document::load(snapshot, visitor); });
+        },
+        [this, &blobs](Journal::Operation operation, const uchar* data, qint64 size){
+            switch (operation) {
+                case Journal::Operation::COMMIT:
+                    return appendDocument([data, size](const DocumentVisitor& visitor){ return Document::read(data, size, visitor); });
+                case Journal::Operation::UNDO:
+                    undo();
+                    return true;
+                case Journal::Operation::REDO:
+                    redo();
+                    return true;
+                case Journal::Operation::CLEAR:
+                    clear();
+                    return true;
+                case Journal::Operation::ERASE: {
+                    if (size <= static_cast<qint64>(sizeof(int)) || (size - sizeof(int)) % sizeof(glm::vec2) != 0) return false;
+
+                    int width = 0;
+                    memcpy(&width, data, sizeof(int));
+                    QVector<glm::vec2> path((size - sizeof(int)) / sizeof(glm::vec2));
+                    memcpy(path.data(), data + sizeof(int), path.size() * sizeof(glm::vec2));
+
+                    makeCurrent();
+                    erase(path, width);
+                    doneCurrent();
+                    return true;
+                }
+                case Journal::Operation::BLOB: {
+                    JournalBlob blob{};
+                    if (size < static_cast<qint64>(sizeof(JournalBlob))) return false;
+                    memcpy(&blob, data, sizeof(JournalBlob));
+
+                    if (blob.width == 0 || blob.height == 0 || size - static_cast<qint64>(sizeof(JournalBlob)) != static_cast<qint64>(blob.width) * blob.height * 4)
+                        return false;
+
+                    blobs.insert(blob.hash, QImage(data + sizeof(JournalBlob), static_cast<int>(blob.width), static_cast<int>(blob.height), QImage::Format::Format_RGBA8888).copy());
+                    return true;
+                }
+                case Journal::Operation::IMAGE: {
+                    JournalImage image{};
+                    if (size != static_cast<qint64>(sizeof(JournalImage))) return false;
+                    memcpy(&image, data, sizeof(JournalImage));
+
+                    const auto blob = blobs.constFind(image.hash);
+                    if (blob == blobs.constEnd()) return false;
+
+                    return appendDocument([&image, &blob](const DocumentVisitor& visitor){
+                        visitor.blob(0, blob.value());
+                        visitor.image(glm::vec2(image.x, image.y), glm::vec2(image.width, image.height), 0);
+                        return true;
+                    });
+                }
+            }
+            return false;
+        }
+    );
+
+    // replayed operations fold into a fresh snapshot, so the journal only ever holds the current session.
+    // A replay that stopped short must not replace the only intact copy with the partial board
+    bool compact = success;
+    if (!success) {
+        qWarning() << "journal: replay stopped at an unreadable record";
+        compact = mJournal.setAside();
+    }
+
+    if (compact) compactJournal();
+    mJournaling = compact && mJournal.isOpen();
+    if (!mJournaling)
+        qWarning() << "journal: unavailable, the board won't survive a crash";
 
     update();
 }
@@ -467,9 +1262,73 @@ int BoardWidget::pointWidth() const {
     return mPointWidth;
 }
 
-std::vector<uchar> BoardWidget::pixels() {
-    const auto size = this->size();
-    std::vector<uchar> bytes(4 * size.width() * size.height(), 0);
-    glReadPixels(0, 0, size.width(), size.height(), GL_RGBA, GL_UNSIGNED_BYTE, bytes.data());
-    return bytes;
+float BoardWidget::simplifyTolerance() const {
+    return mSimplifyTolerance;
+}
+
+float BoardWidget::pointReductionRatio() const {
+    return mCapturedPoints > 0 ? 1.0f - static_cast<float>(mKeptPoints) / static_cast<float>(mCapturedPoints) : 0.0f;
+}
+
+void BoardWidget::exportView(const QString& path) {
+    const auto xSize = size();
+    const Bounds viewport{
+        glm::vec2(static_cast<float>(mOffsetX), static_cast<float>(mOffsetY)),
+        glm::vec2(static_cast<float>(mOffsetX + xSize.width()), static_cast<float>(mOffsetY + xSize.height()))
+    };
+
+    startExport(path, viewport, 1.0f, 0);
+}
+
+void BoardWidget::exportBoard(const QString& path, int dpi) {
+    assert(dpi > 0);
+
+    Bounds area{};
+    if (!mStore->bounds(area)) {
+        exportView(path);
+        return;
+    }
+
+    startExport(path, area, static_cast<float>(dpi) / static_cast<float>(SCREEN_DPI), dpi);
+}
+
+void BoardWidget::startExport(const QString& path, const Bounds& area, float scale, int dpi) {
+    assert(mExporter == nullptr);
+
+    makeCurrent();
+    mExporter = new Exporter(mRenderer->state(), path, area, scale, dpi, format().samples(), ElementPainter::makeGlColor(themeColor()), [this, scale](const Bounds& xArea, const glm::mat4& projection) {
+        mRenderer->setProjection(projection);
+        mPaintScale = scale;
+        mImageCache->setStreaming(false);
+        paintElements(xArea);
+        mImageCache->setStreaming(true);
+        mPaintScale = 1.0f;
+    });
+    doneCurrent();
+
+    connect(mExporter, &Exporter::progress, this, &BoardWidget::exportProgress);
+    connect(mExporter, &Exporter::finished, this, &BoardWidget::exportDone);
+
+    mExportTimer.start();
+}
+
+void BoardWidget::exportStep() {
+    makeCurrent();
+
+    if (!mExporter->step())
+        mExportTimer.stop();
+
+    glBindFramebuffer(GL_FRAMEBUFFER, defaultFramebufferObject());
+    mRenderer->setProjection(mProjection);
+
+    doneCurrent();
+}
+
+void BoardWidget::exportDone(bool success) {
+    makeCurrent();
+    delete mExporter;
+    mExporter = nullptr;
+    doneCurrent();
+
+    emit exportFinished(success);
 }
@@ -22,13 +22,25 @@
 #include "Mode.hpp"
 #include "Theme.hpp"
 #include "Renderer.hpp"
+#include "TileCache.hpp"
+#include "ImageCache.hpp"
+#include "Exporter.hpp"
+#include "Bounds.hpp"
+#include "SpatialIndex.hpp"
+#include "ElementStore.hpp"
+#include "Document.hpp"
+#include "Journal.hpp"
+#include "StatsServer.hpp"
+#include "ElementPainter.hpp"
 #include <functional>
+#include <QTimer>
+#include <QSet>
+#include <QImage>
+#include <QJsonObject>
 #include <QOpenGLWidget>
 #include <QOpenGLFunctions_3_3_Core>
-#include <QStack>
 #include <glm/glm.hpp>
 
-struct DrawnElement;
 struct DrawnPointsSet;
 struct DrawnLine;
 struct DrawnText;
@@ -36,23 +48,61 @@ struct DrawnImage;
 
 class BoardWidget final : public QOpenGLWidget, protected QOpenGLFunctions_3_3_Core {
     Q_OBJECT
+private:
+    struct Generation {
+        ElementStore* store; // owned
+        SpatialIndex* index; // owned
+    };
 private:
     Mode mMode;
     Theme mTheme;
     QColor mColor;
     int mPointWidth;
+    float mSimplifyTolerance;
+    int mCapturedPoints;
+    int mKeptPoints;
+    int mStrokes;
+    bool mReportStrokes;
     glm::mat4 mProjection;
+    float mPaintScale; // of board units to output pixels, above one only while exporting
     Renderer* mRenderer;
+    TileCache* mTileCache;
+    ImageCache* mImageCache;
+    ElementPainter* mPainter;
     int mOffsetX, mOffsetY;
-    QStack<DrawnElement*> mElements;
+    QVector<Generation> mGenerations; // cleared boards below the current one, boards left by undoing a clear above it
+    int mGeneration;
+    ElementStore* mStore; // of the current generation
+    SpatialIndex* mIndex; // of the current generation
+    qint64 mHistoryBudget;
     DrawnPointsSet* mCurrentPointsSet; // nullable
+    QVector<glm::vec2> mStrokeBuffer; // handed from stroke to stroke with its capacity
     DrawnLine* mCurrentLine; // nullable
     DrawnText* mCurrentText; // nullable
     DrawnImage* mCurrentImage; // nullable
     bool mDrawCurrentImage;
+    QTimer mUploadTimer;
+    QTimer mStreamTimer; // of evicted and coarse images coming back
+    Exporter* mExporter; // nullable
+    QTimer mExportTimer;
+    Journal mJournal;
+    bool mJournaling; // off while the board is rebuilt from files
+    QSet<int> mJournaledImages; // cache handles whose pixels the current journal already holds
+    bool mShowStats;
+    QTimer mStatsTimer;
+    int mElementsPainted, mLastElementsPainted;
+    StatsServer* mStatsServer; // nullable
     std::function<void ()> mParentWidgetModeUpdater;
 public:
     static inline int MAX_POINT_WIDTH = 100;
+    static inline float DEFAULT_SIMPLIFY_TOLERANCE = 0.1f; // in stroke widths
+    static inline float MIN_SIMPLIFY_TOLERANCE = 0.5f; // in pixels
+    static inline int SCREEN_DPI = 96; // board units are pixels at this density
+    static inline int UPLOAD_CHUNK_BYTES = 4 * 1024 * 1024; // per event loop iteration
+    static inline int STROKE_RESERVE = 1024; // points
+    static inline int STATS_TEXT_SIZE = 14;
+    static inline int STATS_INTERVAL = 500; // ms between overlay refreshes
+    static inline qint64 DEFAULT_HISTORY_BUDGET = 64ll * 1024 * 1024; // for elements that are undone or cleared away
 public:
     explicit BoardWidget(const std::function<void ()>& parentWidgetModeUpdater);
     ~BoardWidget() override;
@@ -71,23 +121,66 @@ protected:
     void mouseReleaseEvent(QMouseEvent* event) override;
 private:
     void updateProjection();
+    void commitImage();
+    void discardImage();
+    void uploadImageRows(int rows);
+    void startExport(const QString& path, const Bounds& area, float scale, int dpi);
     QColor themeColor();
-    void paintPointsSet(DrawnPointsSet* /*nullable*/ pointsSet);
-    void paintLine(DrawnLine* /*nullable*/ line);
-    void paintText(DrawnText* /*nullable*/ text);
-    void paintImage(DrawnImage* /*nullable*/ image);
+    void committed(int id);
+    bool appendDocument(const std::function<bool (const DocumentVisitor& visitor)>& read);
+    void compactJournal();
+    void erase(const QVector<glm::vec2>& path, int width);
+    void shown(int id, bool visible);
+    void setGeneration(int generation);
+    void deleteGeneration(const Generation& generation);
+    void dropTop(ElementStore& store);
+    void dropTopUnit(ElementStore& store); // the top element with everything joined onto it
+    void discardRedo();
+    void trimHistory();
+    void reset();
+    void paintElements(const Bounds& area);
+    void paintCurrentPointsSet();
+    void paintCurrentLine();
+    void paintCurrentText();
+    void paintCurrentImage();
+    void paintStats();
+private slots:
+    void uploadImageChunk();
+    void streamImages();
+    void exportStep();
+    void exportDone(bool success);
+    void restoreJournal();
 public slots:
     void setMode(Mode mode);
     void setTheme(Theme theme);
     void setColor(const QColor& color);
     void setPointWidth(int width);
-    void setCurrentTexture(const glm::vec2& size, const uchar* data);
+    void setSimplifyTolerance(float tolerance);
+    void setTextureBudget(qint64 bytes);
+    void beginImage(const glm::vec2& size);
+    void setCurrentImage(const QImage& image, size_t hash);
+    void cancelImage();
+    void exportView(const QString& path);
+    void exportBoard(const QString& path, int dpi);
+    void setHistoryBudget(qint64 bytes);
+    void setStatsVisible(bool visible);
     void undo();
+    void redo();
     void clear();
 public:
+    bool saveDocument(const QString& path) const;
+    bool openDocument(const QString& path);
+    bool dumpStats(const QString& path) const;
     Mode mode() const;
     Theme theme() const;
     QColor color() const;
     int pointWidth() const;
-    std::vector<uchar> pixels();
+    float simplifyTolerance() const;
+    float pointReductionRatio() const;
+    qint64 residentTextureBytes() const;
+    qint64 historyBytes() const;
+    QJsonObject stats() const;
+signals:
+    void exportProgress(int percent);
+    void exportFinished(bool success);
 };
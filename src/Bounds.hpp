@@ -0,0 +1,39 @@
+/*
+ * Jaoned - an OpenGL & QT based drawing board
+ * Copyright (C) 2024 Vadim Nikolaev (https://github.com/vadniks).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <glm/glm.hpp>
+
+// axis-aligned box in board (world) coordinates
+struct Bounds {
+    glm::vec2 min;
+    glm::vec2 max;
+
+    bool intersects(const Bounds& other) const {
+        return min.x <= other.max.x && other.min.x <= max.x && min.y <= other.max.y && other.min.y <= max.y;
+    }
+
+    Bounds united(const Bounds& other) const {
+        return {glm::min(min, other.min), glm::max(max, other.max)};
+    }
+
+    Bounds expanded(float amount) const {
+        return {min - glm::vec2(amount), max + glm::vec2(amount)};
+    }
+};
@@ -19,67 +19,84 @@
 #include "CompoundShader.hpp"
 #include <glm/gtc/type_ptr.hpp>
 
-CompoundShader::CompoundShader(QOpenGLFunctions_3_3_Core& gl, const QString& vertexCode, const QString& fragmentCode) : mGl(gl), mProgramId(0) {
+static unsigned compile(QOpenGLFunctions_3_3_Core& gl, unsigned type, const QString& code) {
     int success;
-    unsigned vertex = mGl.glCreateShader(GL_VERTEX_SHADER);
-    mGl.glShaderSource(vertex, 1, (const char*[1]) {vertexCode.toStdString().c_str()}, nullptr);
-    mGl.glCompileShader(vertex);
-    mGl.glGetShaderiv(vertex, GL_COMPILE_STATUS, &success);
+    unsigned shader = gl.glCreateShader(type);
+    gl.glShaderSource(shader, 1, (const char*[1]) {code.toStdString().c_str()}, nullptr);
+    gl.glCompileShader(shader);
+    gl.glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
     assert(success == GL_TRUE);
+    return shader;
+}
 
-    unsigned fragment = mGl.glCreateShader(GL_FRAGMENT_SHADER);
-    mGl.glShaderSource(fragment, 1, (const char*[1]) {fragmentCode.toStdString().c_str()}, nullptr);
-    mGl.glCompileShader(fragment);
-    mGl.glGetShaderiv(fragment, GL_COMPILE_STATUS, &success);
-    assert(success == GL_TRUE);
+CompoundShader::CompoundShader(GlState& state, const QString& vertexCode, const QString& fragmentCode) :
+    CompoundShader(state, vertexCode, QString(), fragmentCode)
+{}
+
+CompoundShader::CompoundShader(GlState& state, const QString& vertexCode, const QString& geometryCode, const QString& fragmentCode) :
+    mState(state), mGl(state.gl()), mProgramId(0)
+{
+    unsigned vertex = compile(mGl, GL_VERTEX_SHADER, vertexCode);
+    unsigned geometry = geometryCode.isEmpty() ? 0 : compile(mGl, GL_GEOMETRY_SHADER, geometryCode);
+    unsigned fragment = compile(mGl, GL_FRAGMENT_SHADER, fragmentCode);
 
+    int success;
     mProgramId = mGl.glCreateProgram();
     mGl.glAttachShader(mProgramId, vertex);
+    if (geometry != 0) mGl.glAttachShader(mProgramId, geometry);
     mGl.glAttachShader(mProgramId, fragment);
     mGl.glLinkProgram(mProgramId);
     mGl.glGetProgramiv(mProgramId, GL_LINK_STATUS, &success);
     assert(success == GL_TRUE);
 
     mGl.glDeleteShader(vertex);
+    if (geometry != 0) mGl.glDeleteShader(geometry);
     mGl.glDeleteShader(fragment);
 }
 
 CompoundShader::~CompoundShader() {
+    mState.forgetProgram(mProgramId);
     mGl.glDeleteProgram(mProgramId);
 }
 
 void CompoundShader::use() {
-    mGl.glUseProgram(mProgramId);
+    mState.useProgram(mProgramId);
+}
+
+void CompoundShader::bindUniformBlock(const char* name, unsigned bindingPoint) {
+    const unsigned index = mGl.glGetUniformBlockIndex(mProgramId, name);
+    assert(index != GL_INVALID_INDEX);
+    mGl.glUniformBlockBinding(mProgramId, index, bindingPoint);
 }
 
-void CompoundShader::setValue(const QString& name, bool value) {
-    mGl.glUniform1i(mGl.glGetUniformLocation(mProgramId, name.toStdString().c_str()), (int) value);
+void CompoundShader::setValue(Uniform<bool> uniform, bool value) {
+    mGl.glUniform1i(uniform.location, (int) value);
 }
 
-void CompoundShader::setValue(const QString& name, float value) {
-    mGl.glUniform1f(mGl.glGetUniformLocation(mProgramId, name.toStdString().c_str()), value);
+void CompoundShader::setValue(Uniform<float> uniform, float value) {
+    mGl.glUniform1f(uniform.location, value);
 }
 
-void CompoundShader::setValue(const QString& name, int value) {
-    mGl.glUniform1i(mGl.glGetUniformLocation(mProgramId, name.toStdString().c_str()), value);
+void CompoundShader::setValue(Uniform<int> uniform, int value) {
+    mGl.glUniform1i(uniform.location, value);
 }
 
-void CompoundShader::setValue(const QString& name, const glm::vec2& value) {
-    mGl.glUniform2f(mGl.glGetUniformLocation(mProgramId, name.toStdString().c_str()), value.x, value.y);
+void CompoundShader::setValue(Uniform<glm::vec2> uniform, const glm::vec2& value) {
+    mGl.glUniform2f(uniform.location, value.x, value.y);
 }
 
-void CompoundShader::setValue(const QString& name, const glm::vec3& value) {
-    mGl.glUniform3f(mGl.glGetUniformLocation(mProgramId, name.toStdString().c_str()), value.x, value.y, value.z);
+void CompoundShader::setValue(Uniform<glm::vec3> uniform, const glm::vec3& value) {
+    mGl.glUniform3f(uniform.location, value.x, value.y, value.z);
 }
 
-void CompoundShader::setValue(const QString& name, const glm::vec4& value) {
-    mGl.glUniform4f(mGl.glGetUniformLocation(mProgramId, name.toStdString().c_str()), value.x, value.y, value.z, value.w);
+void CompoundShader::setValue(Uniform<glm::vec4> uniform, const glm::vec4& value) {
+    mGl.glUniform4f(uniform.location, value.x, value.y, value.z, value.w);
 }
 
-void CompoundShader::setValue(const QString& name, const glm::mat3& value) {
-    mGl.glUniformMatrix3fv(mGl.glGetUniformLocation(mProgramId, name.toStdString().c_str()), 1, GL_FALSE, glm::value_ptr(value));
+void CompoundShader::setValue(Uniform<glm::mat3> uniform, const glm::mat3& value) {
+    mGl.glUniformMatrix3fv(uniform.location, 1, GL_FALSE, glm::value_ptr(value));
 }
 
-void CompoundShader::setValue(const QString& name, const glm::mat4& value) {
-    mGl.glUniformMatrix4fv(mGl.glGetUniformLocation(mProgramId, name.toStdString().c_str()), 1, GL_FALSE, glm::value_ptr(value));
+void CompoundShader::setValue(Uniform<glm::mat4> uniform, const glm::mat4& value) {
+    mGl.glUniformMatrix4fv(uniform.location, 1, GL_FALSE, glm::value_ptr(value));
 }
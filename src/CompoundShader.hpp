@@ -19,27 +19,46 @@
 #pragma once
 
 #include "defs.hpp"
+#include "GlState.hpp"
 #include <QOpenGLFunctions_3_3_Core>
 #include <glm/glm.hpp>
 
+// location resolved once after linking, typed by the value it accepts
+template <typename T>
+struct Uniform final {
+    int location = -1;
+};
+
 class CompoundShader final {
 private:
+    GlState& mState;
     QOpenGLFunctions_3_3_Core& mGl;
     unsigned mProgramId;
 public:
-    CompoundShader(QOpenGLFunctions_3_3_Core& gl, const QString& vertexCode, const QString& fragmentCode);
+    CompoundShader(GlState& state, const QString& vertexCode, const QString& fragmentCode);
+    CompoundShader(GlState& state, const QString& vertexCode, const QString& geometryCode, const QString& fragmentCode);
     ~CompoundShader();
 
     DISABLE_COPY(CompoundShader)
     DISABLE_MOVE(CompoundShader)
 
     void use();
-    void setValue(const QString& name, bool value);
-    void setValue(const QString& name, float value);
-    void setValue(const QString& name, int value);
-    void setValue(const QString& name, const glm::vec2& value);
-    void setValue(const QString& name, const glm::vec3& value);
-    void setValue(const QString& name, const glm::vec4& value);
-    void setValue(const QString& name, const glm::mat3& value);
-    void setValue(const QString& name, const glm::mat4& value);
+
+    template <typename T>
+    Uniform<T> uniform(const char* name) {
+        const int location = mGl.glGetUniformLocation(mProgramId, name);
+        assert(location >= 0);
+        return {location};
+    }
+
+    void bindUniformBlock(const char* name, unsigned bindingPoint);
+
+    void setValue(Uniform<bool> uniform, bool value);
+    void setValue(Uniform<float> uniform, float value);
+    void setValue(Uniform<int> uniform, int value);
+    void setValue(Uniform<glm::vec2> uniform, const glm::vec2& value);
+    void setValue(Uniform<glm::vec3> uniform, const glm::vec3& value);
+    void setValue(Uniform<glm::vec4> uniform, const glm::vec4& value);
+    void setValue(Uniform<glm::mat3> uniform, const glm::mat3& value);
+    void setValue(Uniform<glm::mat4> uniform, const glm::mat4& value);
 };
@@ -20,6 +20,8 @@
 #include <QColorDialog>
 #include <QFileDialog>
 #include <QMessageBox>
+#include <QImageReader>
+#include <QInputDialog>
 
 static QString makeModeString(Mode mode) {
     const QString prefix = "Currently: ";
@@ -41,8 +43,17 @@ ControlsWidget::ControlsWidget(BoardWidget* boardWidget) :
     mBoardWidget(boardWidget),
     mLayout(this),
     mPointWidthLayout(&mPointWidthWidget),
-    mPointWidthSlider(Qt::Orientation::Horizontal)
+    mPointWidthSlider(Qt::Orientation::Horizontal),
+    mImageLoader(),
+    mImageTicket(0),
+    mExportingButton(nullptr),
+    mExportingText()
 {
+    connect(&mImageLoader, &ImageLoader::loaded, this, &ControlsWidget::imageLoaded);
+    connect(&mImageLoader, &ImageLoader::failed, this, &ControlsWidget::imageFailed);
+    connect(mBoardWidget, &BoardWidget::exportProgress, this, &ControlsWidget::exportProgressed);
+    connect(mBoardWidget, &BoardWidget::exportFinished, this, &ControlsWidget::exportFinished);
+
     mLayout.addStretch();
 
     mThemeButton.setText("Switch theme");
@@ -103,16 +114,34 @@ ControlsWidget::ControlsWidget(BoardWidget* boardWidget) :
     connect(&mUndoButton, &QPushButton::clicked, this, &ControlsWidget::undoCLicked);
     mLayout.addWidget(&mUndoButton);
 
+    mRedoButton.setText("Redo");
+    connect(&mRedoButton, &QPushButton::clicked, this, &ControlsWidget::redoClicked);
+    mLayout.addWidget(&mRedoButton);
+
     mClearButton.setText("Clear");
     connect(&mClearButton, &QPushButton::clicked, this, &ControlsWidget::clearClicked);
     mLayout.addWidget(&mClearButton);
 
     mLayout.addStretch();
 
+    mSaveButton.setText("Save");
+    connect(&mSaveButton, &QPushButton::clicked, this, &ControlsWidget::saveClicked);
+    mLayout.addWidget(&mSaveButton);
+
+    mOpenButton.setText("Open");
+    connect(&mOpenButton, &QPushButton::clicked, this, &ControlsWidget::openClicked);
+    mLayout.addWidget(&mOpenButton);
+
+    mLayout.addStretch();
+
     mExportButton.setText("Export");
     connect(&mExportButton, &QPushButton::clicked, this, &ControlsWidget::exportClicked);
     mLayout.addWidget(&mExportButton);
 
+    mExportBoardButton.setText("Export board");
+    connect(&mExportBoardButton, &QPushButton::clicked, this, &ControlsWidget::exportBoardClicked);
+    mLayout.addWidget(&mExportBoardButton);
+
     mLayout.addStretch();
 
     emit updated();
@@ -166,33 +195,87 @@ void ControlsWidget::imageSelectClicked() {
     dialog.exec();
 }
 
+static void showMessage(QWidget* parent, const QString& text) {
+    QMessageBox messageBox(parent);
+    messageBox.setModal(true);
+    messageBox.setText(text);
+    messageBox.exec();
+}
+
 void ControlsWidget::imageSelected(const QString& path) {
-    QPixmap image(path);
+    // only the header is read here, decoding happens on the loader's pool
+    QImageReader reader(path);
+    reader.setAutoTransform(true);
+    const auto sourceSize = reader.size();
 
-    if (image.isNull() || image.size().isNull()) {
-        QMessageBox messageBox(this);
-        messageBox.setModal(true);
-        messageBox.setText("File is not an image");
-        messageBox.exec();
+    if (!reader.canRead() || sourceSize.isEmpty()) {
+        showMessage(this, "File is not an image");
         return;
     }
 
+    const auto size = ImageLoader::decodedSize(sourceSize, mBoardWidget->size() * MAX_IMAGE_SCALE);
+    auto boardSize = size;
+    if (reader.transformation() & QImageIOHandler::Transformation::TransformationRotate90)
+        boardSize.transpose();
+
     modeSelected(Mode::IMAGE);
-    mBoardWidget->setCurrentTexture(glm::vec2(image.width(), image.height()), image.toImage().convertToFormat(QImage::Format::Format_RGBA8888).constBits());
+    mBoardWidget->beginImage(glm::vec2(boardSize.width(), boardSize.height()));
+    mImageTicket = mImageLoader.load(path, size);
 
     emit updated();
 }
 
+void ControlsWidget::imageLoaded(int ticket, const QImage& image, size_t hash) {
+    if (ticket != mImageTicket) return;
+    mBoardWidget->setCurrentImage(image, hash);
+}
+
+void ControlsWidget::imageFailed(int ticket) {
+    if (ticket != mImageTicket) return;
+
+    mBoardWidget->cancelImage();
+    showMessage(this, "File is not an image");
+}
+
 void ControlsWidget::undoCLicked() {
     mBoardWidget->undo();
     emit updated();
 }
 
+void ControlsWidget::redoClicked() {
+    mBoardWidget->redo();
+    emit updated();
+}
+
 void ControlsWidget::clearClicked() {
     mBoardWidget->clear();
     emit updated();
 }
 
+void ControlsWidget::saveClicked() {
+    QFileDialog dialog(this);
+    dialog.setModal(true);
+    dialog.setFileMode(QFileDialog::FileMode::AnyFile);
+    dialog.setAcceptMode(QFileDialog::AcceptMode::AcceptSave);
+    connect(&dialog, &QFileDialog::fileSelected, this, [this](const QString& path){
+        if (!mBoardWidget->saveDocument(path))
+            showMessage(this, "Unable to save the board");
+    });
+    dialog.exec();
+}
+
+void ControlsWidget::openClicked() {
+    QFileDialog dialog(this);
+    dialog.setModal(true);
+    dialog.setFileMode(QFileDialog::FileMode::ExistingFile);
+    connect(&dialog, &QFileDialog::fileSelected, this, [this](const QString& path){
+        if (!mBoardWidget->openDocument(path))
+            showMessage(this, "File is not a board");
+        emit updated();
+    });
+    dialog.exec();
+}
+
 void ControlsWidget::exportClicked() {
     QFileDialog dialog(this);
     dialog.setModal(true);
@@ -201,21 +284,45 @@ void ControlsWidget::exportClicked() {
     dialog.exec();
 }
 
+void ControlsWidget::exportBoardClicked() {
+    bool accepted = false;
+    const int dpi = QInputDialog::getInt(this, "Export board", "DPI:", BoardWidget::SCREEN_DPI, 24, 2400, 1, &accepted);
+    if (!accepted) return;
+
+    QFileDialog dialog(this);
+    dialog.setModal(true);
+    dialog.setFileMode(QFileDialog::FileMode::AnyFile);
+    connect(&dialog, &QFileDialog::fileSelected, this, [this, dpi](const QString& path){
+        setExporting(&mExportBoardButton);
+        mBoardWidget->exportBoard(path, dpi);
+    });
+    dialog.exec();
+}
+
 void ControlsWidget::outputFileSelected(const QString& path) {
-    const auto size = mBoardWidget->size();
-    auto pixels = mBoardWidget->pixels();
-
-    for(int line = 0; line != size.height()/2; ++line)
-        std::swap_ranges(
-            pixels.begin() + 4 * size.width() * line,
-            pixels.begin() + 4 * size.width() * (line + 1),
-            pixels.begin() + 4 * size.width() * (size.height() - line - 1)
-        );
-
-    QImage image(reinterpret_cast<const uchar*>(pixels.data()), size.width(), size.height(), QImage::Format::Format_RGBA8888);
-
-    QFile file(path);
-    file.open(QIODevice::WriteOnly);
-    image.save(&file, "PNG");
-    file.close();
+    setExporting(&mExportButton);
+    mBoardWidget->exportView(path);
+}
+
+void ControlsWidget::setExporting(QPushButton* button) {
+    if (mExportingButton != nullptr)
+        mExportingButton->setText(mExportingText);
+
+    mExportingButton = button;
+    if (button != nullptr)
+        mExportingText = button->text();
+
+    mExportButton.setEnabled(button == nullptr);
+    mExportBoardButton.setEnabled(button == nullptr);
+}
+
+void ControlsWidget::exportProgressed(int percent) {
+    if (mExportingButton != nullptr)
+        mExportingButton->setText(QString("Exporting %1%").arg(percent));
+}
+
+void ControlsWidget::exportFinished(bool success) {
+    setExporting(nullptr);
+
+    if (!success) showMessage(this, "Unable to export");
 }
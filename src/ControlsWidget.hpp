@@ -20,6 +20,7 @@
 
 #include "Mode.hpp"
 #include "BoardWidget.hpp"
+#include "ImageLoader.hpp"
 #include <QWidget>
 #include <QHBoxLayout>
 #include <QPushButton>
@@ -44,11 +45,23 @@ private:
     QPushButton mEraseButton;
     QLabel mModeLabel;
     QPushButton mUndoButton;
+    QPushButton mRedoButton;
     QPushButton mClearButton;
+    QPushButton mSaveButton;
+    QPushButton mOpenButton;
     QPushButton mExportButton;
+    QPushButton mExportBoardButton;
+    ImageLoader mImageLoader;
+    int mImageTicket;
+    QPushButton* mExportingButton; // nullable, the one that started the export in progress
+    QString mExportingText; // of that button before the export
+public:
+    static inline int MAX_IMAGE_SCALE = 2; // relative to the board, larger images get decoded downscaled
 public:
     explicit ControlsWidget(BoardWidget* boardWidget);
     void updateMode();
+private:
+    void setExporting(QPushButton* /*nullable*/ button);
 private slots:
     void themeSwitchClicked();
     void colorChangeClicked();
@@ -57,10 +70,18 @@ private slots:
     void modeSelected(Mode mode);
     void imageSelectClicked();
     void imageSelected(const QString& path);
+    void imageLoaded(int ticket, const QImage& image, size_t hash);
+    void imageFailed(int ticket);
     void undoCLicked();
+    void redoClicked();
     void clearClicked();
+    void saveClicked();
+    void openClicked();
     void exportClicked();
     void outputFileSelected(const QString& path);
+    void exportBoardClicked();
+    void exportProgressed(int percent);
+    void exportFinished(bool success);
 signals:
     void updated(); // implemented elsewhere by QtMoc automatically
 };
@@ -0,0 +1,342 @@
+/*
+ * Jaoned - an OpenGL & QT based drawing board
+ * Copyright (C) 2024 Vadim Nikolaev (https://github.com/vadniks).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "Document.hpp"
+#include <QFile>
+#include <QSaveFile>
+#include <QIODevice>
+#include <QBuffer>
+#include <QHash>
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+
+static const quint32 MAGIC = 0x4452424a; // "JBRD"
+static const quint32 VERSION = 1;
+
+// anything larger is taken for a corrupt file rather than allocated
+static const quint32 MAX_BLOB_SIDE = 32768;
+static const quint32 MAX_POINTS = 1u << 24;
+static const quint32 MAX_TEXT_BYTES = 1u << 20;
+
+struct FileHeader {
+    quint32 magic;
+    quint32 version;
+    quint32 blobs;
+    quint32 elements;
+};
+
+struct BlobHeader {
+    quint32 width;
+    quint32 height;
+};
+
+struct ElementRecord {
+    quint8 type;
+    quint8 erase;
+    quint16 reserved;
+    quint32 color;
+    qint32 width; // or text size
+    quint32 count; // of points, or bytes of text
+};
+
+struct PointsSetRecord {
+    qint32 x, y; // quantized, the rest follow as pairs of deltas
+};
+
+struct LineRecord {
+    float startX, startY, endX, endY;
+};
+
+struct TextRecord {
+    float x, y;
+};
+
+struct ImageRecord {
+    float x, y, width, height;
+    quint32 blob;
+};
+
+static_assert(sizeof(ElementRecord) == 16 && sizeof(ImageRecord) == 20);
+
+static int padded(int bytes) {
+    return (bytes + 3) & ~3;
+}
+
+template <typename T>
+static void writeRecord(QIODevice& file, const T& record) {
+    file.write(reinterpret_cast<const char*>(&record), sizeof(T));
+}
+
+static void writePoints(QIODevice& file, const glm::vec2* points, int count, int width, QRgb color, bool erase) {
+    QVector<qint16> deltas;
+    deltas.reserve(count * 2);
+
+    const auto quantize = [](const glm::vec2& point) {
+        return glm::ivec2(glm::round(point * static_cast<float>(Document::QUANTUM)));
+    };
+
+    auto previous = quantize(points[0]);
+    const auto first = previous;
+
+    for (int i = 1; i < count; i++) {
+        const auto current = quantize(points[i]);
+        const auto delta = current - previous;
+
+        // deltas that don't fit are split into collinear steps that do
+        const int steps = glm::max(1, (glm::max(glm::abs(delta.x), glm::abs(delta.y)) + 32766) / 32767);
+        auto reached = previous;
+        for (int step = 1; step <= steps; step++) {
+            const auto next = previous + delta * step / steps;
+            deltas.push_back(static_cast<qint16>(next.x - reached.x));
+            deltas.push_back(static_cast<qint16>(next.y - reached.y));
+            reached = next;
+        }
+
+        previous = current;
+    }
+
+    const int stored = 1 + static_cast<int>(deltas.size() / 2);
+    writeRecord(file, ElementRecord{static_cast<quint8>(ElementType::POINTS_SET), erase, 0, color, width, static_cast<quint32>(stored)});
+    writeRecord(file, PointsSetRecord{first.x, first.y});
+    file.write(reinterpret_cast<const char*>(deltas.constData()), static_cast<qint64>(deltas.size()) * sizeof(qint16));
+}
+
+static void writeLine(QIODevice& file, const glm::vec2& start, const glm::vec2& end, int width, QRgb color) {
+    writeRecord(file, ElementRecord{static_cast<quint8>(ElementType::LINE), 0, 0, color, width, 0});
+    writeRecord(file, LineRecord{start.x, start.y, end.x, end.y});
+}
+
+static void writeText(QIODevice& file, const QString& text, const glm::vec2& pos, int size, QRgb color) {
+    auto bytes = text.toUtf8();
+    const int length = static_cast<int>(bytes.size());
+    bytes.resize(padded(length), '\0');
+
+    writeRecord(file, ElementRecord{static_cast<quint8>(ElementType::TEXT), 0, 0, color, size, static_cast<quint32>(length)});
+    writeRecord(file, TextRecord{pos.x, pos.y});
+    file.write(bytes);
+}
+
+static QByteArray single(const std::function<void (QIODevice& file)>& element) {
+    QByteArray data;
+    QBuffer buffer(&data);
+    buffer.open(QIODevice::WriteOnly);
+
+    writeRecord(buffer, FileHeader{MAGIC, VERSION, 0, 1});
+    element(buffer);
+    return data;
+}
+
+bool Document::save(const QString& path, const ElementStore& store, const ImageCache& images) {
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) return false;
+
+    // erasures are applied rather than stored, which leaves the draw order as the only order
+    QVector<int> ids;
+    for (int i = 0; i < store.size(); i++) {
+        const auto& header = store.header(i);
+        if (!header.erased && header.type != ElementType::ERASURE) ids.push_back(i);
+    }
+    std::stable_sort(ids.begin(), ids.end(), [&store](int a, int b){ return store.header(a).z < store.header(b).z; });
+
+    // every distinct image once, identical pixels already share a handle
+    QHash<int, int> blobOfImage;
+    QVector<int> blobImages;
+    for (int i : ids) {
+        const auto& header = store.header(i);
+        if (header.type != ElementType::IMAGE) continue;
+
+        const int image = store.image(header).image;
+        if (blobOfImage.contains(image)) continue;
+
+        blobOfImage.insert(image, static_cast<int>(blobImages.size()));
+        blobImages.push_back(image);
+    }
+
+    writeRecord(file, FileHeader{MAGIC, VERSION, static_cast<quint32>(blobImages.size()), static_cast<quint32>(ids.size())});
+
+    for (int i : blobImages) {
+        const auto& image = images.image(i);
+        assert(image.format() == QImage::Format::Format_RGBA8888 && image.bytesPerLine() == image.width() * 4);
+
+        writeRecord(file, BlobHeader{static_cast<quint32>(image.width()), static_cast<quint32>(image.height())});
+        file.write(reinterpret_cast<const char*>(image.constBits()), image.sizeInBytes());
+    }
+
+    for (int i : ids) {
+        const auto& header = store.header(i);
+
+        switch (header.type) {
+            case ElementType::POINTS_SET: {
+                const auto& pointsSet = store.pointsSet(header);
+                writePoints(file, store.points(pointsSet), pointsSet.pointCount, pointsSet.width, pointsSet.color, pointsSet.erase);
+            } break;
+            case ElementType::LINE: {
+                const auto& line = store.line(header);
+                writeLine(file, line.start, line.end, line.width, line.color);
+            } break;
+            case ElementType::TEXT: {
+                const auto& text = store.text(header);
+                writeText(file, text.text, text.pos, text.size, text.color);
+            } break;
+            case ElementType::IMAGE: {
+                const auto& image = store.image(header);
+                writeRecord(file, ElementRecord{static_cast<quint8>(header.type), 0, 0, 0, 0, 0});
+                writeRecord(file, ImageRecord{image.pos.x, image.pos.y, image.size.x, image.size.y, static_cast<quint32>(blobOfImage.value(image.image))});
+            } break;
+            case ElementType::ERASURE:
+                break;
+        }
+    }
+
+    return file.commit();
+}
+
+QByteArray Document::pointsSet(bool erase, int width, QRgb color, const QVector<glm::vec2>& points) {
+    return single([&](QIODevice& file){ writePoints(file, points.constData(), static_cast<int>(points.size()), width, color, erase); });
+}
+
+QByteArray Document::line(const glm::vec2& start, const glm::vec2& end, int width, QRgb color) {
+    return single([&](QIODevice& file){ writeLine(file, start, end, width, color); });
+}
+
+QByteArray Document::text(const QString& text, const glm::vec2& pos, int size, QRgb color) {
+    return single([&](QIODevice& file){ writeText(file, text, pos, size, color); });
+}
+
+// sequential reader over the mapped file that refuses to step past its end
+class Cursor final {
+private:
+    const uchar* mData;
+    qint64 mSize;
+    qint64 mOffset;
+public:
+    Cursor(const uchar* data, qint64 size) : mData(data), mSize(size), mOffset(0) {}
+
+    template <typename T>
+    bool read(T& value) {
+        if (mSize - mOffset < static_cast<qint64>(sizeof(T))) return false;
+        memcpy(&value, mData + mOffset, sizeof(T));
+        mOffset += sizeof(T);
+        return true;
+    }
+
+    qint64 left() const {
+        return mSize - mOffset;
+    }
+
+    const uchar* take(qint64 bytes) {
+        if (bytes < 0 || mSize - mOffset < bytes) return nullptr;
+        const auto* data = mData + mOffset;
+        mOffset += bytes;
+        return data;
+    }
+};
+
+bool Document::load(const QString& path, const DocumentVisitor& visitor) {
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) return false;
+
+    const auto* data = file.map(0, file.size());
+    if (data == nullptr) return false;
+
+    return read(data, file.size(), visitor);
+}
+
+static bool allFinite(std::initializer_list<float> values) {
+    return std::all_of(values.begin(), values.end(), [](float value){ return std::isfinite(value); });
+}
+
+bool Document::read(const uchar* data, qint64 size, const DocumentVisitor& visitor) {
+    Cursor cursor(data, size);
+
+    FileHeader header{};
+    if (!cursor.read(header) || header.magic != MAGIC || header.version != VERSION) return false;
+
+    // every record takes at least its header, so counts beyond what is left can't be honest
+    if (static_cast<qint64>(header.blobs) * sizeof(BlobHeader) + static_cast<qint64>(header.elements) * sizeof(ElementRecord) > cursor.left())
+        return false;
+
+    for (quint32 i = 0; i < header.blobs; i++) {
+        BlobHeader blob{};
+        if (!cursor.read(blob) || blob.width == 0 || blob.height == 0 || blob.width > MAX_BLOB_SIDE || blob.height > MAX_BLOB_SIDE) return false;
+
+        const auto* pixels = cursor.take(static_cast<qint64>(blob.width) * blob.height * 4);
+        if (pixels == nullptr) return false;
+
+        visitor.blob(static_cast<int>(i), QImage(pixels, static_cast<int>(blob.width), static_cast<int>(blob.height), QImage::Format::Format_RGBA8888).copy());
+    }
+
+    QVector<glm::vec2> points;
+
+    for (quint32 i = 0; i < header.elements; i++) {
+        ElementRecord element{};
+        if (!cursor.read(element)) return false;
+
+        switch (static_cast<ElementType>(element.type)) {
+            case ElementType::POINTS_SET: {
+                PointsSetRecord first{};
+                if (element.count == 0 || element.count > MAX_POINTS || element.width <= 0 || !cursor.read(first)) return false;
+
+                const auto* deltas = reinterpret_cast<const qint16*>(cursor.take((static_cast<qint64>(element.count) - 1) * 2 * sizeof(qint16)));
+                if (deltas == nullptr) return false;
+
+                const int count = static_cast<int>(element.count);
+                points.resize(count);
+
+                // wide enough that no run of deltas overflows it
+                qint64 x = first.x, y = first.y;
+                const float scale = 1.0f / static_cast<float>(QUANTUM);
+
+                points[0] = glm::vec2(static_cast<float>(x), static_cast<float>(y)) * scale;
+                for (int j = 1; j < count; j++) {
+                    x += deltas[(j - 1) * 2];
+                    y += deltas[(j - 1) * 2 + 1];
+                    points[j] = glm::vec2(static_cast<float>(x), static_cast<float>(y)) * scale;
+                }
+
+                visitor.pointsSet(element.erase != 0, element.width, element.color, points);
+            } break;
+            case ElementType::LINE: {
+                LineRecord line{};
+                if (element.width <= 0 || !cursor.read(line)) return false;
+                if (!allFinite({line.startX, line.startY, line.endX, line.endY})) return false;
+                visitor.line(glm::vec2(line.startX, line.startY), glm::vec2(line.endX, line.endY), element.width, element.color);
+            } break;
+            case ElementType::TEXT: {
+                TextRecord text{};
+                if (element.count > MAX_TEXT_BYTES || element.width <= 0 || !cursor.read(text) || !allFinite({text.x, text.y})) return false;
+
+                const auto* bytes = cursor.take(padded(static_cast<int>(element.count)));
+                if (bytes == nullptr) return false;
+
+                visitor.text(QString::fromUtf8(reinterpret_cast<const char*>(bytes), element.count), glm::vec2(text.x, text.y), element.width, element.color);
+            } break;
+            case ElementType::IMAGE: {
+                ImageRecord image{};
+                if (!cursor.read(image) || image.blob >= header.blobs) return false;
+                if (!allFinite({image.x, image.y, image.width, image.height}) || image.width <= 0.0f || image.height <= 0.0f) return false;
+                visitor.image(glm::vec2(image.x, image.y), glm::vec2(image.width, image.height), static_cast<int>(image.blob));
+            } break;
+            default:
+                return false;
+        }
+    }
+
+    return true;
+}
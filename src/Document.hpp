@@ -0,0 +1,56 @@
+/*
+ * Jaoned - an OpenGL & QT based drawing board
+ * Copyright (C) 2024 Vadim Nikolaev (https://github.com/vadniks).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "defs.hpp"
+#include "ElementStore.hpp"
+#include "ImageCache.hpp"
+#include <functional>
+#include <QString>
+#include <QImage>
+#include <QVector>
+#include <QRgb>
+#include <glm/glm.hpp>
+
+// receives the contents of a document in draw order, every blob before any image that refers to it
+struct DocumentVisitor {
+    std::function<void (int index, const QImage& image)> blob;
+    std::function<void (bool erase, int width, QRgb color, const QVector<glm::vec2>& points)> pointsSet;
+    std::function<void (const glm::vec2& start, const glm::vec2& end, int width, QRgb color)> line;
+    std::function<void (const QString& text, const glm::vec2& pos, int size, QRgb color)> text;
+    std::function<void (const glm::vec2& pos, const glm::vec2& size, int blob)> image;
+};
+
+// Binary board file: a header, the distinct images as raw RGBA blobs, then the elements as fixed-layout records.
+// Stroke points are quantized to 1/QUANTUM of a pixel and stored as int16 deltas from the previous point,
+// so loading is a prefix sum straight over the mapped file
+class Document final {
+public:
+    static inline int QUANTUM = 4;
+public:
+    Document() = delete;
+
+    static bool save(const QString& path, const ElementStore& store, const ImageCache& images);
+    static bool load(const QString& path, const DocumentVisitor& visitor);
+    static bool read(const uchar* data, qint64 size, const DocumentVisitor& visitor);
+    // documents of a single element, built from copies so that no store needs to be around
+    static QByteArray pointsSet(bool erase, int width, QRgb color, const QVector<glm::vec2>& points);
+    static QByteArray line(const glm::vec2& start, const glm::vec2& end, int width, QRgb color);
+    static QByteArray text(const QString& text, const glm::vec2& pos, int size, QRgb color);
+};
@@ -0,0 +1,133 @@
+/*
+ * Jaoned - an OpenGL & QT based drawing board
+ * Copyright (C) 2024 Vadim Nikolaev (https://github.com/vadniks).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "ElementPainter.hpp"
+#include <algorithm>
+
+ElementPainter::ElementPainter(Renderer& renderer, ImageCache& imageCache) :
+    mRenderer(renderer),
+    mImageCache(imageCache)
+{}
+
+int ElementPainter::paint(const ElementStore& store, const SpatialIndex& index, const Bounds& area, const glm::vec4& background, float scale) {
+    // pieces left by an eraser are drawn where what they were split off was
+    auto ids = index.query(area);
+    std::stable_sort(ids.begin(), ids.end(), [&store](int a, int b){ return store.header(a).z < store.header(b).z; });
+
+    auto& profiler = mRenderer.profiler();
+    for (int i : ids) {
+        const auto& header = store.header(i);
+
+        switch (header.type) {
+            case ElementType::POINTS_SET: {
+                ProfileScope scope(profiler, ProfilePhase::STROKES);
+                paintPointsSet(store.pointsSet(header), background);
+                break;
+            }
+            case ElementType::LINE: {
+                ProfileScope scope(profiler, ProfilePhase::LINES);
+                paintLine(store.line(header));
+                break;
+            }
+            case ElementType::TEXT: {
+                ProfileScope scope(profiler, ProfilePhase::TEXT);
+                paintText(store.text(header));
+                break;
+            }
+            case ElementType::IMAGE: {
+                ProfileScope scope(profiler, ProfilePhase::IMAGES);
+                paintImage(store.image(header), scale);
+                break;
+            }
+            case ElementType::ERASURE:
+                break;
+        }
+    }
+
+    return static_cast<int>(ids.size());
+}
+
+Bounds ElementPainter::textBounds(const QString& text, const glm::vec2& pos, int size) {
+    const auto metrics = mRenderer.textMetrics(text, size);
+    const auto xSize = static_cast<float>(size);
+
+    // glyphs may start left of the pen and descend below the tallest one
+    return {
+        pos - glm::vec2(xSize / 2.0f),
+        pos + glm::vec2(static_cast<float>(metrics.width()) + xSize / 2.0f, static_cast<float>(metrics.height()) + xSize)
+    };
+}
+
+Bounds ElementPainter::pointsBounds(const QVector<glm::vec2>& points, int width) {
+    Bounds bounds{points.first(), points.first()};
+    for (const auto& i : points)
+        bounds = bounds.united({i, i});
+    return bounds.expanded(static_cast<float>(width) / 2.0f + 1.0f);
+}
+
+Bounds ElementPainter::lineBounds(const glm::vec2& start, const glm::vec2& end, int width) {
+    return Bounds{glm::min(start, end), glm::max(start, end)}.expanded(static_cast<float>(width) / 2.0f + 1.0f);
+}
+
+Bounds ElementPainter::imageBounds(const glm::vec2& pos, const glm::vec2& size) {
+    return Bounds{pos, pos + size}.expanded(1.0f);
+}
+
+void ElementPainter::blending(GlState& state, bool enable) {
+    if (enable) {
+        state.setBlending(true);
+        state.setBlendFunction(GL_SRC_COLOR, GL_ONE_MINUS_SRC_ALPHA);
+    } else
+        state.setBlending(false);
+}
+
+glm::vec4 ElementPainter::makeGlColor(const QColor& color) {
+    return {
+        static_cast<float>(color.red()) / 255.0f,
+        static_cast<float>(color.green()) / 255.0f,
+        static_cast<float>(color.blue()) / 255.0f,
+        static_cast<float>(color.alpha()) / 255.0f
+    };
+}
+
+void ElementPainter::paintPointsSet(const PointsSetElement& pointsSet, const glm::vec4& background) {
+    assert(pointsSet.mesh != nullptr);
+    blending(mRenderer.state(), false);
+
+    mRenderer.drawStroke(
+        *(pointsSet.mesh),
+        static_cast<float>(pointsSet.width),
+        pointsSet.erase ? background : makeGlColor(QColor::fromRgba(pointsSet.color))
+    );
+}
+
+void ElementPainter::paintLine(const LineElement& line) {
+    assert(line.mesh != nullptr);
+    blending(mRenderer.state(), false);
+    mRenderer.drawMesh(*(line.mesh), makeGlColor(QColor::fromRgba(line.color)));
+}
+
+void ElementPainter::paintText(const TextElement& text) {
+    blending(mRenderer.state(), true);
+    mRenderer.drawText(text.text, text.size, text.pos, makeGlColor(QColor::fromRgba(text.color)));
+}
+
+void ElementPainter::paintImage(const ImageElement& image, float scale) {
+    blending(mRenderer.state(), true);
+    mRenderer.drawTexture(mImageCache.texture(image.image, image.size * scale), image.pos, image.size, 0.0f, glm::vec4(1.0f));
+}
@@ -0,0 +1,54 @@
+/*
+ * Jaoned - an OpenGL & QT based drawing board
+ * Copyright (C) 2024 Vadim Nikolaev (https://github.com/vadniks).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "defs.hpp"
+#include "Bounds.hpp"
+#include "Renderer.hpp"
+#include "ImageCache.hpp"
+#include "ElementStore.hpp"
+#include "SpatialIndex.hpp"
+#include <QColor>
+#include <QVector>
+#include <glm/glm.hpp>
+
+// Draws committed elements through the renderer, for the board, its exports and the benchmark alike
+class ElementPainter final {
+private:
+    Renderer& mRenderer;
+    ImageCache& mImageCache;
+public:
+    ElementPainter(Renderer& renderer, ImageCache& imageCache);
+
+    DISABLE_COPY(ElementPainter)
+    DISABLE_MOVE(ElementPainter)
+
+    int paint(const ElementStore& store, const SpatialIndex& index, const Bounds& area, const glm::vec4& background, float scale); // elements painted
+    Bounds textBounds(const QString& text, const glm::vec2& pos, int size);
+    static Bounds pointsBounds(const QVector<glm::vec2>& points, int width);
+    static Bounds lineBounds(const glm::vec2& start, const glm::vec2& end, int width);
+    static Bounds imageBounds(const glm::vec2& pos, const glm::vec2& size);
+    static void blending(GlState& state, bool enable);
+    static glm::vec4 makeGlColor(const QColor& color);
+private:
+    void paintPointsSet(const PointsSetElement& pointsSet, const glm::vec4& background);
+    void paintLine(const LineElement& line);
+    void paintText(const TextElement& text);
+    void paintImage(const ImageElement& image, float scale);
+};
@@ -0,0 +1,260 @@
+/*
+ * Jaoned - an OpenGL & QT based drawing board
+ * Copyright (C) 2024 Vadim Nikolaev (https://github.com/vadniks).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "ElementStore.hpp"
+#include <algorithm>
+
+ElementStore::ElementStore() : mHeaders(), mPointsSets(), mLines(), mTexts(), mImages(), mErasures(), mPoints(), mTargets(), mVisible(0), mBytes(0), mHiddenBytes(0) {}
+
+ElementStore::~ElementStore() {
+    clear();
+}
+
+int ElementStore::pushPointsSet(bool erase, int width, QRgb color, const glm::vec2* points, int count, Mesh* mesh, const Bounds& bounds) {
+    auto* stored = mPoints.allocate(count);
+    std::copy(points, points + count, stored);
+    mPointsSets.push_back({erase, width, color, stored, count, mesh});
+    return pushHeader(ElementType::POINTS_SET, static_cast<int>(mPointsSets.size()) - 1, bounds);
+}
+
+int ElementStore::pushLine(const glm::vec2& start, const glm::vec2& end, int width, QRgb color, Mesh* mesh, const Bounds& bounds) {
+    mLines.push_back({start, end, width, color, mesh});
+    return pushHeader(ElementType::LINE, static_cast<int>(mLines.size()) - 1, bounds);
+}
+
+int ElementStore::pushText(const QString& text, const glm::vec2& pos, int size, QRgb color, const Bounds& bounds) {
+    mTexts.push_back({text, pos, size, color});
+    return pushHeader(ElementType::TEXT, static_cast<int>(mTexts.size()) - 1, bounds);
+}
+
+int ElementStore::pushImage(const glm::vec2& pos, const glm::vec2& size, int image, const Bounds& bounds) {
+    mImages.push_back({pos, size, image});
+    return pushHeader(ElementType::IMAGE, static_cast<int>(mImages.size()) - 1, bounds);
+}
+
+int ElementStore::pushErasure(const QVector<int>& targets, const Bounds& bounds) {
+    mErasures.push_back({static_cast<int>(mTargets.size()), static_cast<int>(targets.size())});
+    mTargets.append(targets);
+    setErased(mErasures.last(), true);
+    return pushHeader(ElementType::ERASURE, static_cast<int>(mErasures.size()) - 1, bounds);
+}
+
+void ElementStore::join(int id, int z) {
+    assert(id > 0 && id < mHeaders.size());
+    mHeaders[id].joined = true;
+    mHeaders[id].z = z;
+}
+
+void ElementStore::pop() {
+    assert(!mHeaders.isEmpty());
+
+    const int id = static_cast<int>(mHeaders.size()) - 1;
+    const bool visible = id < mVisible;
+    const auto bytes = elementBytes(id);
+    mBytes -= bytes;
+    if (visible)
+        mVisible--;
+    else
+        mHiddenBytes -= bytes;
+
+    switch (mHeaders.last().type) {
+        case ElementType::POINTS_SET:
+            delete mPointsSets.last().mesh;
+            mPoints.release(mPointsSets.last().points);
+            mPointsSets.removeLast();
+            break;
+        case ElementType::LINE:
+            delete mLines.last().mesh;
+            mLines.removeLast();
+            break;
+        case ElementType::TEXT:
+            mTexts.removeLast();
+            break;
+        case ElementType::IMAGE:
+            mImages.removeLast();
+            break;
+        case ElementType::ERASURE:
+            if (visible) setErased(mErasures.last(), false);
+            mTargets.resize(mErasures.last().firstTarget);
+            mErasures.removeLast();
+            break;
+    }
+
+    mHeaders.removeLast();
+}
+
+void ElementStore::clear() {
+    for (const auto& i : mPointsSets)
+        delete i.mesh;
+    for (const auto& i : mLines)
+        delete i.mesh;
+
+    mHeaders.clear();
+    mPointsSets.clear();
+    mLines.clear();
+    mTexts.clear();
+    mImages.clear();
+    mErasures.clear();
+    mPoints.clear();
+    mTargets.clear();
+    mVisible = 0;
+    mBytes = 0;
+    mHiddenBytes = 0;
+}
+
+void ElementStore::hide() {
+    assert(mVisible > 0);
+    mVisible--;
+    mHiddenBytes += elementBytes(mVisible);
+
+    const auto& header = mHeaders[mVisible];
+    if (header.type == ElementType::ERASURE)
+        setErased(mErasures[header.payload], false);
+}
+
+void ElementStore::show() {
+    assert(hiddenCount() > 0);
+    mHiddenBytes -= elementBytes(mVisible);
+
+    const auto& header = mHeaders[mVisible];
+    if (header.type == ElementType::ERASURE)
+        setErased(mErasures[header.payload], true);
+
+    mVisible++;
+}
+
+int ElementStore::size() const {
+    return mVisible;
+}
+
+bool ElementStore::isEmpty() const {
+    return mVisible == 0;
+}
+
+int ElementStore::hiddenCount() const {
+    return static_cast<int>(mHeaders.size()) - mVisible;
+}
+
+qint64 ElementStore::bytes() const {
+    return mBytes;
+}
+
+qint64 ElementStore::hiddenBytes() const {
+    return mHiddenBytes;
+}
+
+const PointArena& ElementStore::pointArena() const {
+    return mPoints;
+}
+
+bool ElementStore::bounds(Bounds& bounds) const {
+    // erasures draw nothing but cover everything they erased, what is left of it is covered by the pieces
+    bool found = false;
+    for (int i = 0; i < mVisible; i++) {
+        const auto& header = mHeaders[i];
+        if (header.erased || header.type == ElementType::ERASURE) continue;
+
+        bounds = found ? bounds.united(header.bounds) : header.bounds;
+        found = true;
+    }
+    return found;
+}
+
+const ElementHeader& ElementStore::header(int id) const {
+    assert(id >= 0 && id < mHeaders.size());
+    return mHeaders[id];
+}
+
+const PointsSetElement& ElementStore::pointsSet(const ElementHeader& header) const {
+    assert(header.type == ElementType::POINTS_SET);
+    return mPointsSets[header.payload];
+}
+
+const LineElement& ElementStore::line(const ElementHeader& header) const {
+    assert(header.type == ElementType::LINE);
+    return mLines[header.payload];
+}
+
+const TextElement& ElementStore::text(const ElementHeader& header) const {
+    assert(header.type == ElementType::TEXT);
+    return mTexts[header.payload];
+}
+
+const ImageElement& ElementStore::image(const ElementHeader& header) const {
+    assert(header.type == ElementType::IMAGE);
+    return mImages[header.payload];
+}
+
+const ErasureElement& ElementStore::erasure(const ElementHeader& header) const {
+    assert(header.type == ElementType::ERASURE);
+    return mErasures[header.payload];
+}
+
+const glm::vec2* ElementStore::points(const PointsSetElement& pointsSet) const {
+    return pointsSet.points;
+}
+
+const int* ElementStore::targets(const ErasureElement& erasure) const {
+    return mTargets.constData() + erasure.firstTarget;
+}
+
+int ElementStore::pushHeader(ElementType type, int payload, const Bounds& bounds) {
+    assert(hiddenCount() == 0);
+
+    const int id = static_cast<int>(mHeaders.size());
+    mHeaders.push_back({type, false, false, payload, id, bounds});
+    mVisible++;
+
+    mBytes += elementBytes(id);
+    return id;
+}
+
+qint64 ElementStore::elementBytes(int id) const {
+    // image pixels are left out, they belong to the image cache
+    const auto& header = mHeaders[id];
+    qint64 bytes = sizeof(ElementHeader);
+
+    switch (header.type) {
+        case ElementType::POINTS_SET: {
+            const auto& pointsSet = mPointsSets[header.payload];
+            bytes += sizeof(PointsSetElement) + static_cast<qint64>(pointsSet.pointCount) * sizeof(glm::vec2);
+            if (pointsSet.mesh != nullptr) bytes += static_cast<qint64>(pointsSet.mesh->count()) * sizeof(glm::vec2);
+        } break;
+        case ElementType::LINE: {
+            const auto& line = mLines[header.payload];
+            bytes += sizeof(LineElement);
+            if (line.mesh != nullptr) bytes += static_cast<qint64>(line.mesh->count()) * sizeof(glm::vec2);
+        } break;
+        case ElementType::TEXT:
+            bytes += sizeof(TextElement) + static_cast<qint64>(mTexts[header.payload].text.size()) * sizeof(QChar);
+            break;
+        case ElementType::IMAGE:
+            bytes += sizeof(ImageElement);
+            break;
+        case ElementType::ERASURE:
+            bytes += sizeof(ErasureElement) + static_cast<qint64>(mErasures[header.payload].targetCount) * sizeof(int);
+            break;
+    }
+
+    return bytes;
+}
+
+void ElementStore::setErased(const ErasureElement& erasure, bool erased) {
+    for (int i = 0; i < erasure.targetCount; i++)
+        mHeaders[mTargets[erasure.firstTarget + i]].erased = erased;
+}
@@ -0,0 +1,132 @@
+/*
+ * Jaoned - an OpenGL & QT based drawing board
+ * Copyright (C) 2024 Vadim Nikolaev (https://github.com/vadniks).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "defs.hpp"
+#include "Bounds.hpp"
+#include "Mesh.hpp"
+#include "PointArena.hpp"
+#include <QVector>
+#include <QString>
+#include <QRgb>
+#include <glm/glm.hpp>
+
+enum class ElementType : uchar {
+    POINTS_SET, LINE, TEXT, IMAGE, ERASURE
+};
+
+struct ElementHeader {
+    ElementType type;
+    bool erased; // by an erasure above, no longer part of the board
+    bool joined; // undone and redone together with the element below
+    int payload; // index into the array of this type
+    int z; // draw order, the id unless the element was split off another one
+    Bounds bounds;
+};
+
+struct PointsSetElement {
+    bool erase;
+    int width;
+    QRgb color;
+    const glm::vec2* points; // in the store's arena
+    int pointCount;
+    Mesh* mesh; // owned
+};
+
+struct LineElement {
+    glm::vec2 start;
+    glm::vec2 end;
+    int width;
+    QRgb color;
+    Mesh* mesh; // owned
+};
+
+struct TextElement {
+    QString text;
+    glm::vec2 pos;
+    int size;
+    QRgb color;
+};
+
+struct ImageElement {
+    glm::vec2 pos;
+    glm::vec2 size;
+    int image; // handle in the image cache, released by whoever pops the element
+};
+
+// marks the elements an eraser went through as erased while it's visible, what remained of them is joined above it
+struct ErasureElement {
+    int firstTarget; // index into the shared erased ids buffer
+    int targetCount;
+};
+
+// Committed elements in draw order: type-tagged headers in one contiguous array, payloads in per-type arrays
+// and stroke points in one chunked arena. Elements only ever leave from the top, so every array is a stack.
+// Undone elements stay stored above the visible ones until they are redone, popped or pushed over
+class ElementStore final {
+private:
+    QVector<ElementHeader> mHeaders;
+    QVector<PointsSetElement> mPointsSets;
+    QVector<LineElement> mLines;
+    QVector<TextElement> mTexts;
+    QVector<ImageElement> mImages;
+    QVector<ErasureElement> mErasures;
+    PointArena mPoints;
+    QVector<int> mTargets;
+    int mVisible;
+    qint64 mBytes;
+    qint64 mHiddenBytes;
+public:
+    ElementStore();
+    ~ElementStore();
+
+    DISABLE_COPY(ElementStore)
+    DISABLE_MOVE(ElementStore)
+
+    int pushPointsSet(bool erase, int width, QRgb color, const glm::vec2* points, int count, Mesh* mesh, const Bounds& bounds);
+    int pushLine(const glm::vec2& start, const glm::vec2& end, int width, QRgb color, Mesh* mesh, const Bounds& bounds);
+    int pushText(const QString& text, const glm::vec2& pos, int size, QRgb color, const Bounds& bounds);
+    int pushImage(const glm::vec2& pos, const glm::vec2& size, int image, const Bounds& bounds);
+    int pushErasure(const QVector<int>& targets, const Bounds& bounds);
+    void join(int id, int z); // to the element below, drawn at the given depth
+    void pop(); // the top stored element, hidden or not
+    void clear();
+    void hide(); // the top visible element
+    void show(); // the bottom hidden element
+
+    int size() const; // of visible elements
+    bool isEmpty() const;
+    int hiddenCount() const;
+    qint64 bytes() const; // roughly, of everything stored
+    qint64 hiddenBytes() const;
+    const PointArena& pointArena() const;
+    const ElementHeader& header(int id) const; // hidden ones come after the visible
+    bool bounds(Bounds& bounds) const; // of everything drawn, false when nothing is
+    const PointsSetElement& pointsSet(const ElementHeader& header) const;
+    const LineElement& line(const ElementHeader& header) const;
+    const TextElement& text(const ElementHeader& header) const;
+    const ImageElement& image(const ElementHeader& header) const;
+    const ErasureElement& erasure(const ElementHeader& header) const;
+    const glm::vec2* points(const PointsSetElement& pointsSet) const;
+    const int* targets(const ErasureElement& erasure) const;
+private:
+    int pushHeader(ElementType type, int payload, const Bounds& bounds);
+    void setErased(const ErasureElement& erasure, bool erased);
+    qint64 elementBytes(int id) const;
+};
@@ -0,0 +1,126 @@
+/*
+ * Jaoned - an OpenGL & QT based drawing board
+ * Copyright (C) 2024 Vadim Nikolaev (https://github.com/vadniks).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "Eraser.hpp"
+#include <algorithm>
+
+static float pointSegmentDistance(const glm::vec2& point, const glm::vec2& start, const glm::vec2& end) {
+    const auto direction = end - start;
+    const float lengthSquared = glm::dot(direction, direction);
+    if (lengthSquared == 0.0f) return glm::distance(point, start);
+
+    const float t = glm::clamp(glm::dot(point - start, direction) / lengthSquared, 0.0f, 1.0f);
+    return glm::distance(point, start + direction * t);
+}
+
+static float cross(const glm::vec2& a, const glm::vec2& b) {
+    return a.x * b.y - a.y * b.x;
+}
+
+static bool segmentsIntersect(const glm::vec2& a, const glm::vec2& b, const glm::vec2& c, const glm::vec2& d) {
+    const float d1 = cross(b - a, c - a), d2 = cross(b - a, d - a);
+    const float d3 = cross(d - c, a - c), d4 = cross(d - c, b - c);
+    return ((d1 > 0.0f) != (d2 > 0.0f)) && ((d3 > 0.0f) != (d4 > 0.0f));
+}
+
+Eraser::Eraser(const QVector<glm::vec2>& path, float width) : mPath(path), mRadius(width / 2.0f) {
+    assert(!mPath.isEmpty());
+}
+
+bool Eraser::cut(const glm::vec2* points, int count, float width, QVector<QVector<glm::vec2>>& runs) const {
+    assert(count > 0);
+
+    // nothing of the stroke may show under the eraser, its own half width included
+    const float reach = mRadius + width / 2.0f;
+
+    if (count == 1)
+        return distance(points[0]) < reach;
+
+    bool touched = false;
+    bool lastInterior = false; // the last point of the run is a sample inside the current segment
+    QVector<glm::vec2> run;
+
+    const auto close = [&]() {
+        if (run.size() >= 2) runs.push_back(run);
+        run.clear();
+        lastInterior = false;
+    };
+
+    if (distance(points[0]) < reach)
+        touched = true;
+    else
+        run.push_back(points[0]);
+
+    for (int i = 1; i < count; i++) {
+        const auto& start = points[i - 1];
+        const auto& end = points[i];
+        lastInterior = false;
+
+        if (distance(start, end) >= reach) {
+            run.push_back(end);
+            continue;
+        }
+
+        // samples on a kept stretch of one segment are collinear, only the ends of the stretch stay
+        const int steps = glm::max(1, static_cast<int>(glm::ceil(glm::distance(start, end) / (reach * SAMPLE_STEP))));
+        for (int step = 1; step <= steps; step++) {
+            const auto point = step < steps ? glm::mix(start, end, static_cast<float>(step) / static_cast<float>(steps)) : end;
+
+            if (distance(point) < reach) {
+                touched = true;
+                close();
+                continue;
+            }
+
+            if (run.size() >= 2 && lastInterior)
+                run.last() = point;
+            else
+                run.push_back(point);
+            lastInterior = step < steps;
+        }
+    }
+
+    if (!touched) return false;
+
+    close();
+    return true;
+}
+
+float Eraser::distance(const glm::vec2& point) const {
+    float distance = glm::distance(point, mPath.first());
+    for (int i = 1; i < mPath.size(); i++)
+        distance = glm::min(distance, pointSegmentDistance(point, mPath[i - 1], mPath[i]));
+    return distance;
+}
+
+float Eraser::distance(const glm::vec2& start, const glm::vec2& end) const {
+    float distance = pointSegmentDistance(mPath.first(), start, end);
+    for (int i = 1; i < mPath.size(); i++) {
+        const auto& pathStart = mPath[i - 1];
+        const auto& pathEnd = mPath[i];
+        if (segmentsIntersect(start, end, pathStart, pathEnd)) return 0.0f;
+
+        distance = std::min({
+            distance,
+            pointSegmentDistance(pathEnd, start, end),
+            pointSegmentDistance(start, pathStart, pathEnd),
+            pointSegmentDistance(end, pathStart, pathEnd)
+        });
+    }
+    return distance;
+}
@@ -0,0 +1,43 @@
+/*
+ * Jaoned - an OpenGL & QT based drawing board
+ * Copyright (C) 2024 Vadim Nikolaev (https://github.com/vadniks).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "defs.hpp"
+#include <QVector>
+#include <glm/glm.hpp>
+
+// Cuts polylines along the path of an eraser, what the eraser didn't reach comes out as separate runs
+class Eraser final {
+private:
+    QVector<glm::vec2> mPath;
+    float mRadius;
+public:
+    static inline float SAMPLE_STEP = 0.25f; // in reach distances, along segments that pass near the path
+public:
+    Eraser(const QVector<glm::vec2>& path, float width);
+
+    DISABLE_COPY(Eraser)
+    DISABLE_MOVE(Eraser)
+
+    // false if the polyline is out of reach, runs are only filled otherwise and may stay empty
+    bool cut(const glm::vec2* points, int count, float width, QVector<QVector<glm::vec2>>& runs) const;
+private:
+    float distance(const glm::vec2& point) const;
+    float distance(const glm::vec2& start, const glm::vec2& end) const;
+};
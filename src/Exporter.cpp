@@ -0,0 +1,209 @@
+/*
+ * Jaoned - an OpenGL & QT based drawing board
+ * Copyright (C) 2024 Vadim Nikolaev (https://github.com/vadniks).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "Exporter.hpp"
+#include <glm/ext/matrix_clip_space.hpp>
+
+Exporter::Exporter(GlState& state, const QString& path, const Bounds& area, float scale, int dpi, int samples, const glm::vec4& background, const Painter& painter) :
+    mState(state),
+    mGl(state.gl()),
+    mArea(area),
+    mWidth(static_cast<int>(glm::ceil((area.max.x - area.min.x) * scale))),
+    mHeight(static_cast<int>(glm::ceil((area.max.y - area.min.y) * scale))),
+    mScale(scale),
+    mBackground(background),
+    mPainter(painter),
+    mSamples(samples),
+    mMultisampleFramebuffer(0),
+    mMultisampleRenderbuffer(0),
+    mFramebuffer(0),
+    mRenderbuffer(0),
+    mSlots(),
+    mBandRows(0),
+    mBands(0),
+    mNextBand(0),
+    mReadBands(0),
+    mQueuedBands(0),
+    mWrittenRows(0),
+    mWriter(nullptr),
+    mPool()
+{
+    assert(mWidth > 0 && mHeight > 0 && scale > 0.0f);
+
+    mWriter = new PngWriter(path, mWidth, mHeight, dpi);
+    mPool.setMaxThreadCount(1);
+    mBandRows = static_cast<int>(glm::clamp(MAX_BAND_BYTES / (static_cast<qint64>(mWidth) * 4), 1ll, static_cast<qint64>(BAND_ROWS)));
+    mBands = (mHeight + mBandRows - 1) / mBandRows;
+
+    const int columns = glm::min(COLUMN_WIDTH, mWidth), rows = glm::min(mBandRows, mHeight);
+
+    mGl.glGenRenderbuffers(1, &mRenderbuffer);
+    mGl.glBindRenderbuffer(GL_RENDERBUFFER, mRenderbuffer);
+    mGl.glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, columns, rows);
+
+    mGl.glGenFramebuffers(1, &mFramebuffer);
+    mGl.glBindFramebuffer(GL_FRAMEBUFFER, mFramebuffer);
+    mGl.glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, mRenderbuffer);
+    assert(mGl.glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE);
+
+    if (mSamples > 0) {
+        mGl.glGenRenderbuffers(1, &mMultisampleRenderbuffer);
+        mGl.glBindRenderbuffer(GL_RENDERBUFFER, mMultisampleRenderbuffer);
+        mGl.glRenderbufferStorageMultisample(GL_RENDERBUFFER, mSamples, GL_RGBA8, columns, rows);
+
+        mGl.glGenFramebuffers(1, &mMultisampleFramebuffer);
+        mGl.glBindFramebuffer(GL_FRAMEBUFFER, mMultisampleFramebuffer);
+        mGl.glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, mMultisampleRenderbuffer);
+        assert(mGl.glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE);
+    }
+
+    mGl.glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+    for (auto& i : mSlots) {
+        i = {0, nullptr, -1};
+        mGl.glGenBuffers(1, &i.pixelBuffer);
+        mState.bindBuffer(GL_PIXEL_PACK_BUFFER, i.pixelBuffer);
+        mGl.glBufferData(GL_PIXEL_PACK_BUFFER, static_cast<long>(mWidth) * rows * 4, nullptr, GL_STREAM_READ);
+    }
+
+    mState.bindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+}
+
+Exporter::~Exporter() {
+    mPool.waitForDone();
+
+    for (auto& i : mSlots) {
+        if (i.fence != nullptr) mGl.glDeleteSync(i.fence);
+        mState.forgetBuffer(i.pixelBuffer);
+        mGl.glDeleteBuffers(1, &i.pixelBuffer);
+    }
+
+    mGl.glDeleteFramebuffers(1, &mFramebuffer);
+    mGl.glDeleteRenderbuffers(1, &mRenderbuffer);
+
+    if (mSamples > 0) {
+        mGl.glDeleteFramebuffers(1, &mMultisampleFramebuffer);
+        mGl.glDeleteRenderbuffers(1, &mMultisampleRenderbuffer);
+    }
+
+    delete mWriter;
+}
+
+bool Exporter::step() {
+    // fences signal in submission order, so bands are collected and encoded in order too
+    for (bool collected = true; collected;) {
+        collected = false;
+
+        for (auto& i : mSlots) {
+            if (i.fence == nullptr || i.band != mReadBands) continue;
+
+            const auto status = mGl.glClientWaitSync(i.fence, 0, 0);
+            if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) continue;
+
+            collect(i);
+            collected = true;
+        }
+    }
+
+    for (auto& i : mSlots) {
+        if (i.fence != nullptr || mNextBand == mBands || mQueuedBands.loadRelaxed() >= MAX_QUEUED_BANDS) continue;
+        render(i, mNextBand++);
+    }
+
+    return mReadBands < mBands;
+}
+
+int Exporter::width() const {
+    return mWidth;
+}
+
+int Exporter::height() const {
+    return mHeight;
+}
+
+int Exporter::bandRows(int band) const {
+    return glm::min(mBandRows, mHeight - band * mBandRows);
+}
+
+void Exporter::render(Slot& slot, int band) {
+    const int y0 = band * mBandRows, rows = bandRows(band);
+
+    mState.bindBuffer(GL_PIXEL_PACK_BUFFER, slot.pixelBuffer);
+    mGl.glPixelStorei(GL_PACK_ROW_LENGTH, mWidth);
+
+    for (int x0 = 0; x0 < mWidth; x0 += COLUMN_WIDTH) {
+        const int columns = glm::min(COLUMN_WIDTH, mWidth - x0);
+        const Bounds area{
+            mArea.min + glm::vec2(static_cast<float>(x0), static_cast<float>(y0)) / mScale,
+            mArea.min + glm::vec2(static_cast<float>(x0 + columns), static_cast<float>(y0 + rows)) / mScale
+        };
+
+        mGl.glBindFramebuffer(GL_FRAMEBUFFER, mSamples > 0 ? mMultisampleFramebuffer : mFramebuffer);
+        mGl.glViewport(0, 0, columns, rows);
+        mGl.glClearColor(mBackground.r, mBackground.g, mBackground.b, mBackground.a);
+        mGl.glClear(GL_COLOR_BUFFER_BIT);
+
+        // bottom and top are swapped relative to the screen projection so that the area's top lands in row 0
+        mPainter(area, glm::ortho(area.min.x, area.max.x, area.min.y, area.max.y, -1.0f, 1.0f));
+
+        if (mSamples > 0) {
+            mGl.glBindFramebuffer(GL_READ_FRAMEBUFFER, mMultisampleFramebuffer);
+            mGl.glBindFramebuffer(GL_DRAW_FRAMEBUFFER, mFramebuffer);
+            mGl.glBlitFramebuffer(0, 0, columns, rows, 0, 0, columns, rows, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+        }
+
+        mGl.glBindFramebuffer(GL_READ_FRAMEBUFFER, mFramebuffer);
+        mGl.glReadPixels(0, 0, columns, rows, GL_RGBA, GL_UNSIGNED_BYTE, reinterpret_cast<void*>(static_cast<qintptr>(x0) * 4));
+    }
+
+    mGl.glPixelStorei(GL_PACK_ROW_LENGTH, 0);
+    mState.bindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    slot.fence = mGl.glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    slot.band = band;
+    mGl.glFlush();
+}
+
+void Exporter::collect(Slot& slot) {
+    mGl.glDeleteSync(slot.fence);
+    slot.fence = nullptr;
+
+    const int rows = bandRows(slot.band);
+    const long bytes = static_cast<long>(mWidth) * rows * 4;
+
+    mState.bindBuffer(GL_PIXEL_PACK_BUFFER, slot.pixelBuffer);
+    const auto* mapped = static_cast<const char*>(mGl.glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, bytes, GL_MAP_READ_BIT));
+    assert(mapped != nullptr);
+    QByteArray pixels(mapped, bytes);
+    mGl.glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    mState.bindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    mReadBands++;
+    mQueuedBands.ref();
+
+    mPool.start([this, pixels, rows](){
+        mWriter->writeRows(reinterpret_cast<const uchar*>(pixels.constData()), rows);
+        mQueuedBands.deref();
+
+        const int written = mWrittenRows.fetchAndAddOrdered(rows) + rows;
+        emit progress(static_cast<int>(100ll * written / mHeight));
+
+        if (written == mHeight)
+            emit finished(mWriter->finish());
+    });
+}
@@ -0,0 +1,86 @@
+/*
+ * Jaoned - an OpenGL & QT based drawing board
+ * Copyright (C) 2024 Vadim Nikolaev (https://github.com/vadniks).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "defs.hpp"
+#include "GlState.hpp"
+#include "Bounds.hpp"
+#include "PngWriter.hpp"
+#include <functional>
+#include <QObject>
+#include <QThreadPool>
+#include <QAtomicInt>
+#include <QOpenGLFunctions_3_3_Core>
+#include <glm/glm.hpp>
+
+// Renders an area of the board at any scale band by band, and every band column by column, into a small offscreen framebuffer, reads every band back through
+// a pixel buffer object guarded by a fence and hands its rows to a PngWriter on a worker thread.
+// The projection puts the top of the area into row 0, so no flip is needed on the way to the encoder.
+// step() is to be called repeatedly with the context current until it returns false
+class Exporter final : public QObject {
+    Q_OBJECT
+public:
+    using Painter = std::function<void (const Bounds& area, const glm::mat4& projection)>;
+private:
+    struct Slot {
+        unsigned pixelBuffer;
+        GLsync fence; // nullable
+        int band;
+    };
+
+    GlState& mState;
+    QOpenGLFunctions_3_3_Core& mGl;
+    Bounds mArea;
+    int mWidth, mHeight;
+    float mScale;
+    glm::vec4 mBackground;
+    Painter mPainter;
+    int mSamples;
+    unsigned mMultisampleFramebuffer, mMultisampleRenderbuffer;
+    unsigned mFramebuffer, mRenderbuffer;
+    Slot mSlots[2];
+    int mBandRows;
+    int mBands, mNextBand, mReadBands;
+    QAtomicInt mQueuedBands;
+    QAtomicInt mWrittenRows;
+    PngWriter* mWriter;
+    QThreadPool mPool;
+public:
+    static inline int BAND_ROWS = 256;
+    static inline qint64 MAX_BAND_BYTES = 64ll * 1024 * 1024; // wide exports get fewer rows per band
+    static inline int COLUMN_WIDTH = 2048;
+    static inline int MAX_QUEUED_BANDS = 4;
+public:
+    Exporter(GlState& state, const QString& path, const Bounds& area, float scale, int dpi, int samples, const glm::vec4& background, const Painter& painter);
+    ~Exporter() override;
+
+    DISABLE_COPY(Exporter)
+    DISABLE_MOVE(Exporter)
+
+    bool step();
+    int width() const;
+    int height() const;
+private:
+    int bandRows(int band) const;
+    void render(Slot& slot, int band);
+    void collect(Slot& slot);
+signals:
+    void progress(int percent);
+    void finished(bool success);
+};
@@ -0,0 +1,201 @@
+/*
+ * Jaoned - an OpenGL & QT based drawing board
+ * Copyright (C) 2024 Vadim Nikolaev (https://github.com/vadniks).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "GlState.hpp"
+#include <QDebug>
+
+GlState::GlState(QOpenGLFunctions_3_3_Core& gl) :
+    mGl(gl),
+    mProgram(0),
+    mVertexArray(0),
+    mBuffers(),
+    mActiveUnit(-1),
+    mTextures(),
+    mBlending(-1),
+    mBlendSource(-1),
+    mBlendDestination(-1),
+    mPointSize(-1.0f),
+    mIssued(0),
+    mSkipped(0),
+    mLastIssued(0),
+    mLastSkipped(0),
+    mCounters(),
+    mLastCounters(),
+    mReport(qEnvironmentVariableIsSet("JAONED_GL_STATS"))
+{
+    beginFrame();
+}
+
+QOpenGLFunctions_3_3_Core& GlState::gl() {
+    return mGl;
+}
+
+void GlState::useProgram(unsigned program) {
+    if (!track(mProgram != program)) return;
+    mProgram = program;
+    mGl.glUseProgram(program);
+}
+
+void GlState::bindVertexArray(unsigned vertexArray) {
+    if (!track(mVertexArray != vertexArray)) return;
+    mVertexArray = vertexArray;
+    mGl.glBindVertexArray(vertexArray);
+}
+
+void GlState::bindBuffer(unsigned target, unsigned buffer) {
+    const int slot = bufferSlot(target);
+    if (!track(mBuffers[slot] != buffer)) return;
+    mBuffers[slot] = buffer;
+    mGl.glBindBuffer(target, buffer);
+}
+
+void GlState::bindTexture(int unit, unsigned texture) {
+    assert(unit >= 0 && unit < TEXTURE_UNITS);
+    if (!track(mTextures[unit] != texture)) return;
+
+    if (mActiveUnit != unit) {
+        mActiveUnit = unit;
+        mGl.glActiveTexture(GL_TEXTURE0 + unit);
+    }
+
+    mTextures[unit] = texture;
+    mGl.glBindTexture(GL_TEXTURE_2D, texture);
+}
+
+void GlState::setBlending(bool enable) {
+    if (!track(mBlending != static_cast<int>(enable))) return;
+    mBlending = static_cast<int>(enable);
+
+    if (enable)
+        mGl.glEnable(GL_BLEND);
+    else
+        mGl.glDisable(GL_BLEND);
+}
+
+void GlState::setBlendFunction(int source, int destination) {
+    if (!track(mBlendSource != source || mBlendDestination != destination)) return;
+    mBlendSource = source;
+    mBlendDestination = destination;
+    mGl.glBlendFunc(source, destination);
+}
+
+void GlState::setPointSize(float size) {
+    if (!track(mPointSize != size)) return;
+    mPointSize = size;
+    mGl.glPointSize(size);
+}
+
+// a deleted program stays in use until another one replaces it
+void GlState::forgetProgram(unsigned program) {
+    if (mProgram == program) mProgram = static_cast<unsigned>(-1);
+}
+
+void GlState::forgetVertexArray(unsigned vertexArray) {
+    if (mVertexArray == vertexArray) mVertexArray = 0;
+}
+
+void GlState::forgetBuffer(unsigned buffer) {
+    for (auto& i : mBuffers)
+        if (i == buffer) i = 0;
+}
+
+void GlState::forgetTexture(unsigned texture) {
+    for (auto& i : mTextures)
+        if (i == texture) i = 0;
+}
+
+// Qt may touch the context between frames (e.g. when resolving the multisampled framebuffer), so each frame starts from scratch
+void GlState::beginFrame() {
+    mProgram = static_cast<unsigned>(-1);
+    mVertexArray = static_cast<unsigned>(-1);
+    for (auto& i : mBuffers) i = static_cast<unsigned>(-1);
+    mActiveUnit = -1;
+    for (auto& i : mTextures) i = static_cast<unsigned>(-1);
+    mBlending = -1;
+    mBlendSource = -1;
+    mBlendDestination = -1;
+    mPointSize = -1.0f;
+
+    mIssued = 0;
+    mSkipped = 0;
+}
+
+void GlState::endFrame() {
+    mLastIssued = mIssued;
+    mLastSkipped = mSkipped;
+
+    // uploads between frames are counted towards the next one, unlike the state calls
+    mLastCounters = mCounters;
+    mCounters = FrameCounters();
+
+    if (mReport)
+        qDebug() << "gl state: issued" << mIssued << "skipped" << mSkipped << "draws" << mLastCounters.drawCalls;
+}
+
+int GlState::issuedCalls() const {
+    return mLastIssued;
+}
+
+int GlState::skippedCalls() const {
+    return mLastSkipped;
+}
+
+void GlState::countDraw() {
+    mCounters.drawCalls++;
+}
+
+void GlState::countBufferData(qint64 bytes) {
+    mCounters.bufferBytes += bytes;
+}
+
+void GlState::countTextureUpload(qint64 bytes) {
+    mCounters.textureUploads++;
+    mCounters.textureBytes += bytes;
+}
+
+void GlState::countGlyphLoad() {
+    mCounters.glyphLoads++;
+}
+
+const FrameCounters& GlState::lastFrame() const {
+    return mLastCounters;
+}
+
+int GlState::bufferSlot(unsigned target) const {
+    switch (target) {
+        case GL_ARRAY_BUFFER:
+            return 0;
+        case GL_UNIFORM_BUFFER:
+            return 1;
+        case GL_PIXEL_PACK_BUFFER:
+            return 2;
+        case GL_PIXEL_UNPACK_BUFFER:
+            return 3;
+        default:
+            assert(false);
+            return 0;
+    }
+}
+
+bool GlState::track(bool changed) {
+    if (changed)
+        mIssued++;
+    else
+        mSkipped++;
+    return changed;
+}
@@ -0,0 +1,86 @@
+/*
+ * Jaoned - an OpenGL & QT based drawing board
+ * Copyright (C) 2024 Vadim Nikolaev (https://github.com/vadniks).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "defs.hpp"
+#include <QOpenGLFunctions_3_3_Core>
+
+// work issued through the context since the previous frame ended
+struct FrameCounters {
+    int drawCalls;
+    qint64 bufferBytes;
+    int textureUploads;
+    qint64 textureBytes;
+    int glyphLoads;
+};
+
+// Remembers what is bound/enabled and drops calls that wouldn't change anything
+class GlState final {
+private:
+    static const int TEXTURE_UNITS = 8;
+    static const int BUFFER_TARGETS = 4;
+
+    QOpenGLFunctions_3_3_Core& mGl;
+    unsigned mProgram;
+    unsigned mVertexArray;
+    unsigned mBuffers[BUFFER_TARGETS];
+    int mActiveUnit;
+    unsigned mTextures[TEXTURE_UNITS];
+    int mBlending; // -1 - unknown, 0 - disabled, 1 - enabled
+    int mBlendSource, mBlendDestination;
+    float mPointSize;
+    int mIssued, mSkipped;
+    int mLastIssued, mLastSkipped;
+    FrameCounters mCounters, mLastCounters;
+    bool mReport;
+public:
+    explicit GlState(QOpenGLFunctions_3_3_Core& gl);
+
+    DISABLE_COPY(GlState)
+    DISABLE_MOVE(GlState)
+
+    QOpenGLFunctions_3_3_Core& gl();
+
+    void useProgram(unsigned program);
+    void bindVertexArray(unsigned vertexArray);
+    void bindBuffer(unsigned target, unsigned buffer);
+    void bindTexture(int unit, unsigned texture);
+    void setBlending(bool enable);
+    void setBlendFunction(int source, int destination);
+    void setPointSize(float size);
+
+    void forgetProgram(unsigned program);
+    void forgetVertexArray(unsigned vertexArray);
+    void forgetBuffer(unsigned buffer);
+    void forgetTexture(unsigned texture);
+
+    void beginFrame();
+    void endFrame();
+    int issuedCalls() const;
+    int skippedCalls() const;
+
+    void countDraw();
+    void countBufferData(qint64 bytes);
+    void countTextureUpload(qint64 bytes);
+    void countGlyphLoad();
+    const FrameCounters& lastFrame() const;
+private:
+    int bufferSlot(unsigned target) const;
+    bool track(bool changed);
+};
@@ -0,0 +1,113 @@
+/*
+ * Jaoned - an OpenGL & QT based drawing board
+ * Copyright (C) 2024 Vadim Nikolaev (https://github.com/vadniks).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "GlyphAtlas.hpp"
+#include <freetype/ftmodapi.h>
+
+static const int PADDING = 1;
+
+GlyphAtlas::GlyphAtlas(GlState& state, FT_Face face) :
+    mState(state),
+    mFace(face),
+    mPages(),
+    mPenX(0),
+    mPenY(0),
+    mRowHeight(0),
+    mGlyphs()
+{
+    const FT_Int spread = SPREAD;
+    assert(FT_Property_Set(mFace->glyph->library, "sdf", "spread", &spread) == 0);
+    assert(FT_Set_Pixel_Sizes(mFace, 0, BASE_SIZE) == 0);
+}
+
+GlyphAtlas::~GlyphAtlas() {
+    for (auto i : mPages)
+        delete i;
+}
+
+const Glyph& GlyphAtlas::glyph(unsigned index) {
+    auto iterator = mGlyphs.constFind(index);
+    if (iterator == mGlyphs.constEnd())
+        iterator = mGlyphs.insert(index, rasterize(index));
+
+    return iterator.value();
+}
+
+Texture& GlyphAtlas::page(int index) {
+    assert(index >= 0 && index < mPages.size());
+    return *(mPages[index]);
+}
+
+int GlyphAtlas::pages() const {
+    return static_cast<int>(mPages.size());
+}
+
+Glyph GlyphAtlas::rasterize(unsigned index) {
+    assert(FT_Load_Glyph(mFace, index, FT_LOAD_DEFAULT) == 0);
+    mState.countGlyphLoad();
+
+    // glyphs without contours (spaces) only have an advance
+    const bool empty = mFace->glyph->format == FT_GLYPH_FORMAT_OUTLINE && mFace->glyph->outline.n_contours == 0;
+    if (!empty)
+        assert(FT_Render_Glyph(mFace->glyph, FT_RENDER_MODE_SDF) == 0);
+
+    const auto& bitmap = mFace->glyph->bitmap;
+    const int width = empty ? 0 : static_cast<int>(bitmap.width), height = empty ? 0 : static_cast<int>(bitmap.rows);
+    assert(width + 2 * PADDING <= PAGE_SIZE && height + 2 * PADDING <= PAGE_SIZE);
+
+    if (mPages.isEmpty())
+        addPage();
+
+    if (mPenX + width + PADDING > PAGE_SIZE) {
+        mPenX = PADDING;
+        mPenY += mRowHeight + PADDING;
+        mRowHeight = 0;
+    }
+
+    if (mPenY + height + PADDING > PAGE_SIZE)
+        addPage();
+
+    Glyph glyph{
+        static_cast<int>(mPages.size()) - 1,
+        glm::vec2(static_cast<float>(mPenX), static_cast<float>(mPenY)) / static_cast<float>(PAGE_SIZE),
+        glm::vec2(static_cast<float>(mPenX + width), static_cast<float>(mPenY + height)) / static_cast<float>(PAGE_SIZE),
+        glm::ivec2(glm::max(width - 2 * SPREAD, 0), glm::max(height - 2 * SPREAD, 0)),
+        glm::ivec2(mFace->glyph->bitmap_left + SPREAD, mFace->glyph->bitmap_top - SPREAD),
+        static_cast<float>(mFace->glyph->advance.x) / 64.0f
+    };
+
+    if (width > 0 && height > 0) {
+        assert(bitmap.pitch == width);
+        mPages.last()->update(mPenX, mPenY, width, height, bitmap.buffer);
+    }
+
+    mPenX += width + PADDING;
+    if (height > mRowHeight)
+        mRowHeight = height;
+
+    return glyph;
+}
+
+void GlyphAtlas::addPage() {
+    const QVector<uchar> blank(PAGE_SIZE * PAGE_SIZE, 0);
+    mPages.push_back(new Texture(mState, PAGE_SIZE, PAGE_SIZE, blank.constData(), GL_RED));
+
+    mPenX = PADDING;
+    mPenY = PADDING;
+    mRowHeight = 0;
+}
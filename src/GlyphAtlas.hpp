@@ -0,0 +1,66 @@
+/*
+ * Jaoned - an OpenGL & QT based drawing board
+ * Copyright (C) 2024 Vadim Nikolaev (https://github.com/vadniks).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "defs.hpp"
+#include "Texture.hpp"
+#include "GlState.hpp"
+#include <QOpenGLFunctions_3_3_Core>
+#include <QVector>
+#include <QHash>
+#include <glm/glm.hpp>
+#include <freetype2/ft2build.h>
+#include <freetype/freetype.h>
+
+// metrics are those of the ink box at BASE_SIZE, the texture region extends SPREAD pixels beyond it on every side
+struct Glyph {
+    int page;
+    glm::vec2 uvMin, uvMax;
+    glm::ivec2 size;
+    glm::ivec2 bearing;
+    float advance;
+};
+
+// Packs signed distance fields of glyphs into a few large GL_RED pages that live as long as the atlas itself.
+// Each glyph is rendered once at BASE_SIZE and scaled to any size when drawn
+class GlyphAtlas final {
+private:
+    GlState& mState;
+    FT_Face mFace; // owned by the caller
+    QVector<Texture*> mPages;
+    int mPenX, mPenY, mRowHeight;
+    QHash<unsigned, Glyph> mGlyphs;
+public:
+    static inline int PAGE_SIZE = 1024;
+    static inline int BASE_SIZE = 48;
+    static inline int SPREAD = 6;
+public:
+    GlyphAtlas(GlState& state, FT_Face face);
+    ~GlyphAtlas();
+
+    DISABLE_COPY(GlyphAtlas)
+    DISABLE_MOVE(GlyphAtlas)
+
+    const Glyph& glyph(unsigned index);
+    Texture& page(int index);
+    int pages() const;
+private:
+    Glyph rasterize(unsigned index);
+    void addPage();
+};
@@ -0,0 +1,183 @@
+/*
+ * Jaoned - an OpenGL & QT based drawing board
+ * Copyright (C) 2024 Vadim Nikolaev (https://github.com/vadniks).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "GpuProfiler.hpp"
+#include <QJsonDocument>
+#include <QDebug>
+#include <algorithm>
+#include <cmath>
+
+static const char* const PHASE_NAMES[] = {
+    "frame", "clear", "tiles", "strokes", "lines", "text", "images", "current", "overlay",
+    "drawStroke", "drawShape", "drawText", "drawTexture"
+};
+
+static_assert(sizeof(PHASE_NAMES) / sizeof(PHASE_NAMES[0]) == static_cast<int>(ProfilePhase::COUNT));
+
+GpuProfiler::GpuProfiler(QOpenGLFunctions_3_3_Core& gl) :
+    mGl(gl),
+    mFrames(),
+    mFrame(0),
+    mInFrame(false),
+    mCpu(),
+    mEntered(),
+    mHistory(),
+    mClock(),
+    mDropped(0),
+    mFrameCount(0),
+    mReport(qEnvironmentVariableIsSet("JAONED_GPU_STATS"))
+{
+    for (auto& i : mFrames) {
+        i.queries.resize(MAX_SCOPES * 2);
+        mGl.glGenQueries(static_cast<int>(i.queries.size()), i.queries.data());
+        i.used = 0;
+    }
+
+    for (auto& i : mHistory) {
+        i.nextGpu = 0;
+        i.nextCpu = 0;
+    }
+
+    mClock.start();
+}
+
+GpuProfiler::~GpuProfiler() {
+    for (auto& i : mFrames)
+        mGl.glDeleteQueries(static_cast<int>(i.queries.size()), i.queries.constData());
+}
+
+void GpuProfiler::beginFrame() {
+    // the slot about to be reused holds the oldest frame still in flight
+    mFrame = (mFrame + 1) % FRAMES_IN_FLIGHT;
+    collect(mFrames[mFrame]);
+
+    for (int i = 0; i < PHASES; i++) {
+        mCpu[i] = 0;
+        mEntered[i] = false;
+    }
+
+    mInFrame = true;
+}
+
+void GpuProfiler::endFrame() {
+    for (int i = 0; i < PHASES; i++)
+        if (mEntered[i]) record(mHistory[i].cpu, mHistory[i].nextCpu, static_cast<float>(mCpu[i]) / 1000.0f);
+
+    mInFrame = false;
+    mFrameCount++;
+
+    if (mReport && mFrameCount % REPORT_INTERVAL == 0)
+        qDebug().noquote() << "gpu profile:" << QJsonDocument(stats()).toJson(QJsonDocument::JsonFormat::Compact) << "dropped frames" << mDropped;
+}
+
+int GpuProfiler::begin(ProfilePhase phase) {
+    if (!mInFrame) return -1;
+    mEntered[static_cast<int>(phase)] = true;
+
+    auto& frame = mFrames[mFrame];
+    if (frame.used == MAX_SCOPES) return -1;
+
+    const int scope = frame.used++;
+    frame.phases.push_back(phase);
+    mGl.glQueryCounter(frame.queries[scope * 2], GL_TIMESTAMP);
+    return scope;
+}
+
+void GpuProfiler::end(ProfilePhase phase, int scope, qint64 cpuStart) {
+    if (!mInFrame) return;
+
+    mCpu[static_cast<int>(phase)] += now() - cpuStart;
+    if (scope >= 0)
+        mGl.glQueryCounter(mFrames[mFrame].queries[scope * 2 + 1], GL_TIMESTAMP);
+}
+
+qint64 GpuProfiler::now() const {
+    return mClock.nsecsElapsed();
+}
+
+QJsonObject GpuProfiler::stats() const {
+    QJsonObject stats;
+    for (int i = 0; i < PHASES; i++) {
+        const auto& history = mHistory[i];
+        if (history.gpu.isEmpty() && history.cpu.isEmpty()) continue;
+
+        QJsonObject phase;
+        summarize(phase, "gpu", history.gpu);
+        summarize(phase, "cpu", history.cpu);
+        stats.insert(PHASE_NAMES[i], phase);
+    }
+    return stats;
+}
+
+void GpuProfiler::collect(Frame& frame) {
+    if (frame.used == 0) return;
+
+    // asking for a result that isn't there yet would wait for the GPU, so such a frame goes unmeasured
+    for (int i = 0; i < frame.used * 2; i++) {
+        int available = 0;
+        mGl.glGetQueryObjectiv(frame.queries[i], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (available == 0) {
+            mDropped++;
+            frame.used = 0;
+            frame.phases.clear();
+            return;
+        }
+    }
+
+    qint64 gpu[PHASES] = {};
+    bool seen[PHASES] = {};
+    for (int i = 0; i < frame.used; i++) {
+        GLuint64 begin = 0, end = 0;
+        mGl.glGetQueryObjectui64v(frame.queries[i * 2], GL_QUERY_RESULT, &begin);
+        mGl.glGetQueryObjectui64v(frame.queries[i * 2 + 1], GL_QUERY_RESULT, &end);
+
+        const int phase = static_cast<int>(frame.phases[i]);
+        gpu[phase] += static_cast<qint64>(end - begin);
+        seen[phase] = true;
+    }
+
+    for (int i = 0; i < PHASES; i++)
+        if (seen[i]) record(mHistory[i].gpu, mHistory[i].nextGpu, static_cast<float>(gpu[i]) / 1000.0f);
+
+    frame.used = 0;
+    frame.phases.clear();
+}
+
+void GpuProfiler::record(QVector<float>& ring, int& next, float value) {
+    if (ring.size() < HISTORY)
+        ring.push_back(value);
+    else
+        ring[next] = value;
+    next = (next + 1) % HISTORY;
+}
+
+void GpuProfiler::summarize(QJsonObject& object, const QString& prefix, const QVector<float>& ring) {
+    if (ring.isEmpty()) return;
+
+    auto sorted = ring;
+    std::sort(sorted.begin(), sorted.end());
+
+    double sum = 0.0;
+    for (float i : sorted)
+        sum += i;
+
+    const int p99 = std::max(0, static_cast<int>(std::ceil(0.99 * static_cast<double>(sorted.size()))) - 1);
+    object.insert(prefix + "Min", sorted.first());
+    object.insert(prefix + "Avg", sum / static_cast<double>(sorted.size()));
+    object.insert(prefix + "P99", sorted[p99]);
+}
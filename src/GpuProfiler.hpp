@@ -0,0 +1,99 @@
+/*
+ * Jaoned - an OpenGL & QT based drawing board
+ * Copyright (C) 2024 Vadim Nikolaev (https://github.com/vadniks).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "defs.hpp"
+#include <QOpenGLFunctions_3_3_Core>
+#include <QElapsedTimer>
+#include <QJsonObject>
+#include <QVector>
+
+enum class ProfilePhase : int {
+    FRAME, CLEAR, TILES, STROKES, LINES, TEXT, IMAGES, CURRENT, OVERLAY, // of paintGL
+    DRAW_STROKE, DRAW_SHAPE, DRAW_TEXT, DRAW_TEXTURE, // renderer draw families
+    COUNT
+};
+
+// GPU and CPU time of every phase, summed over a frame and kept over the last frames for min/avg/p99.
+// GPU time comes from timestamp queries so phases may nest. They are read a few frames later and only
+// once available, a frame whose results are still in flight is dropped rather than waited for
+class GpuProfiler final {
+private:
+    static const int PHASES = static_cast<int>(ProfilePhase::COUNT);
+    static const int FRAMES_IN_FLIGHT = 3;
+
+    struct Frame {
+        QVector<unsigned> queries; // begin and end timestamp of every scope
+        QVector<ProfilePhase> phases; // of every scope
+        int used; // scopes
+    };
+
+    struct History {
+        QVector<float> gpu, cpu; // microseconds, rings
+        int nextGpu, nextCpu;
+    };
+
+    QOpenGLFunctions_3_3_Core& mGl;
+    Frame mFrames[FRAMES_IN_FLIGHT];
+    int mFrame;
+    bool mInFrame;
+    qint64 mCpu[PHASES]; // nanoseconds this frame
+    bool mEntered[PHASES];
+    History mHistory[PHASES];
+    QElapsedTimer mClock;
+    int mDropped;
+    int mFrameCount;
+    bool mReport;
+public:
+    static inline int MAX_SCOPES = 512; // per frame, further ones are timed on the CPU only
+    static inline int HISTORY = 120; // frames
+    static inline int REPORT_INTERVAL = 120; // frames
+public:
+    explicit GpuProfiler(QOpenGLFunctions_3_3_Core& gl);
+    ~GpuProfiler();
+
+    DISABLE_COPY(GpuProfiler)
+    DISABLE_MOVE(GpuProfiler)
+
+    void beginFrame();
+    void endFrame();
+    int begin(ProfilePhase phase); // a scope to end, or -1 outside of frames and past the query budget
+    void end(ProfilePhase phase, int scope, qint64 cpuStart);
+    qint64 now() const;
+    QJsonObject stats() const;
+private:
+    void collect(Frame& frame);
+    static void record(QVector<float>& ring, int& next, float value);
+    static void summarize(QJsonObject& object, const QString& prefix, const QVector<float>& ring);
+};
+
+// times what's left of the enclosing block as the given phase
+class ProfileScope final {
+private:
+    GpuProfiler& mProfiler;
+    ProfilePhase mPhase;
+    qint64 mCpuStart;
+    int mScope;
+public:
+    ProfileScope(GpuProfiler& profiler, ProfilePhase phase) : mProfiler(profiler), mPhase(phase), mCpuStart(profiler.now()), mScope(profiler.begin(phase)) {}
+    ~ProfileScope() { mProfiler.end(mPhase, mScope, mCpuStart); }
+
+    DISABLE_COPY(ProfileScope)
+    DISABLE_MOVE(ProfileScope)
+};
@@ -0,0 +1,335 @@
+/*
+ * Jaoned - an OpenGL & QT based drawing board
+ * Copyright (C) 2024 Vadim Nikolaev (https://github.com/vadniks).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "ImageCache.hpp"
+#include <QDebug>
+#include <algorithm>
+
+// a full mip chain adds a third on top of the base level
+static qint64 textureBytes(int width, int height) {
+    return static_cast<qint64>(width) * height * 4 * 4 / 3;
+}
+
+static QSize levelSize(const QImage& image, int level) {
+    return {glm::max(1, image.width() >> level), glm::max(1, image.height() >> level)};
+}
+
+static QImage levelImage(const QImage& image, int level, Qt::TransformationMode mode) {
+    if (level == 0) return image;
+    return ImageLoader::resized(image, levelSize(image, level), mode);
+}
+
+static int previewLevel(const QImage& image) {
+    int level = 0;
+    while (glm::max(image.width(), image.height()) >> level > ImageCache::PREVIEW_SIZE)
+        level++;
+    return level;
+}
+
+static int maxLevel(const QImage& image) {
+    int level = 0;
+    while ((image.width() >> (level + 1)) > 0 && (image.height() >> (level + 1)) > 0)
+        level++;
+    return level;
+}
+
+ImageCache::ImageCache(GlState& state) :
+    mState(state),
+    mEntries(),
+    mHandleOfHash(),
+    mNextHandle(0),
+    mBudget(DEFAULT_BUDGET),
+    mResident(0),
+    mFrame(0),
+    mEvictions(0),
+    mStreaming(true),
+    mStreamed(),
+    mLoader(),
+    mReport(qEnvironmentVariableIsSet("JAONED_TEXTURE_STATS"))
+{
+    QObject::connect(&mLoader, &ImageLoader::scaled, &mLoader, [this](int ticket, QImage image){ scaled(ticket, image); });
+}
+
+ImageCache::~ImageCache() {
+    clear();
+}
+
+size_t ImageCache::contentHash(const QImage& image) {
+    const size_t seed = qHash(image.width()) ^ qHash(image.height());
+    return qHashBits(image.constBits(), static_cast<size_t>(image.sizeInBytes()), seed);
+}
+
+int ImageCache::acquire(const QImage& image, size_t hash) {
+    const auto handle = mHandleOfHash.constFind(hash);
+    if (handle == mHandleOfHash.constEnd()) return -1;
+
+    auto& entry = mEntries[handle.value()];
+    if (entry.image != image) return -1;
+
+    entry.references++;
+    return handle.value();
+}
+
+int ImageCache::add(const QImage& image, size_t hash, Texture* texture) {
+    assert(image.format() == QImage::Format::Format_RGBA8888);
+
+    if (const int shared = acquire(image, hash); shared >= 0) {
+        delete texture;
+        return shared;
+    }
+
+    const int handle = mNextHandle++;
+    mEntries.insert(handle, {image, hash, 1, texture, 0, 0, mFrame, nullptr, QImage(), 0, 0, 0});
+    if (!mHandleOfHash.contains(hash))
+        mHandleOfHash.insert(hash, handle);
+
+    if (texture != nullptr) {
+        assert(texture->size() == image.size());
+        texture->generateMipmaps();
+        mResident += textureBytes(image.width(), image.height());
+    }
+
+    return handle;
+}
+
+void ImageCache::remove(int handle) {
+    auto iterator = mEntries.find(handle);
+    assert(iterator != mEntries.end());
+
+    auto& entry = iterator.value();
+    if (--entry.references > 0) return;
+
+    if (mHandleOfHash.value(entry.hash, -1) == handle)
+        mHandleOfHash.remove(entry.hash);
+
+    release(entry);
+    cancel(entry);
+    mEntries.erase(iterator);
+}
+
+void ImageCache::clear() {
+    for (auto& i : mEntries) {
+        release(i);
+        cancel(i);
+    }
+    mEntries.clear();
+    mHandleOfHash.clear();
+}
+
+const QImage& ImageCache::image(int handle) const {
+    auto iterator = mEntries.find(handle);
+    assert(iterator != mEntries.end());
+    return iterator.value().image;
+}
+
+size_t ImageCache::hash(int handle) const {
+    auto iterator = mEntries.find(handle);
+    assert(iterator != mEntries.end());
+    return iterator.value().hash;
+}
+
+Texture& ImageCache::texture(int handle, const glm::vec2& displaySize) {
+    auto iterator = mEntries.find(handle);
+    assert(iterator != mEntries.end());
+    auto& entry = iterator.value();
+
+    const float ratio = glm::min(
+        static_cast<float>(entry.image.width()) / glm::max(displaySize.x, 1.0f),
+        static_cast<float>(entry.image.height()) / glm::max(displaySize.y, 1.0f)
+    );
+    entry.neededLevel = glm::clamp(static_cast<int>(glm::floor(glm::log2(glm::max(ratio, 1.0f)))), 0, maxLevel(entry.image));
+    entry.lastUse = mFrame;
+
+    if (entry.texture != nullptr && entry.level <= entry.neededLevel)
+        return *(entry.texture);
+
+    // a preview costs next to nothing to sample and upload, filtering anything finer would stall the frame
+    const int preview = glm::max(entry.neededLevel, previewLevel(entry.image));
+    if (!mStreaming || preview == 0) {
+        cancel(entry);
+        upload(entry, entry.neededLevel, Qt::TransformationMode::SmoothTransformation);
+    } else {
+        request(entry, entry.neededLevel);
+        if (entry.texture == nullptr) upload(entry, preview, Qt::TransformationMode::FastTransformation);
+    }
+
+    return *(entry.texture);
+}
+
+void ImageCache::beginFrame() {
+    mFrame++;
+    mEvictions = 0;
+}
+
+void ImageCache::endFrame() {
+    if (mResident > mBudget) {
+        QVector<Entry*> candidates;
+        for (auto& i : mEntries)
+            if (i.texture != nullptr)
+                candidates.push_back(&i);
+
+        std::sort(candidates.begin(), candidates.end(), [](const Entry* a, const Entry* b) {
+            return a->lastUse < b->lastUse;
+        });
+
+        // first shrink what is shown smaller than it's stored, then drop the least recently used
+        for (auto i : candidates) {
+            if (mResident <= mBudget) break;
+            if (i->level >= i->neededLevel) continue;
+
+            // the finer level stays resident until the coarser one is filtered
+            if (mStreaming) {
+                request(*i, i->neededLevel);
+            } else {
+                cancel(*i);
+                upload(*i, i->neededLevel, Qt::TransformationMode::SmoothTransformation);
+            }
+        }
+
+        for (auto i : candidates) {
+            if (mResident <= mBudget) break;
+            if (i->lastUse == mFrame) continue;
+
+            release(*i);
+            cancel(*i);
+            mEvictions++;
+        }
+    }
+
+    if (mReport)
+        qDebug() << "textures: resident" << mResident << "of" << mBudget << "bytes, evicted" << mEvictions;
+}
+
+void ImageCache::setBudget(qint64 bytes) {
+    assert(bytes > 0);
+    mBudget = bytes;
+}
+
+qint64 ImageCache::budget() const {
+    return mBudget;
+}
+
+qint64 ImageCache::residentBytes() const {
+    return mResident;
+}
+
+void ImageCache::setStreaming(bool enabled) {
+    mStreaming = enabled;
+}
+
+bool ImageCache::stream(qint64 bytes) {
+    for (auto i = mEntries.begin(); i != mEntries.end() && bytes > 0; i++) {
+        auto& entry = i.value();
+        if (entry.pendingImage.isNull()) continue;
+
+        const auto& image = entry.pendingImage;
+        if (entry.pending == nullptr) {
+            entry.pending = new Texture(mState, image.width(), image.height(), nullptr);
+            mResident += textureBytes(image.width(), image.height());
+        }
+        const int rows = glm::min(image.height() - entry.pendingRows, glm::max(1, static_cast<int>(bytes / image.bytesPerLine())));
+        entry.pending->update(0, entry.pendingRows, image.width(), rows, image.constScanLine(entry.pendingRows));
+        entry.pendingRows += rows;
+        bytes -= static_cast<qint64>(rows) * image.bytesPerLine();
+
+        if (entry.pendingRows < image.height()) continue;
+
+        release(entry);
+        entry.pending->generateMipmaps();
+        entry.texture = entry.pending;
+        entry.level = entry.pendingLevel;
+        entry.pending = nullptr;
+        entry.pendingImage = QImage();
+        mStreamed.push_back(i.key());
+    }
+
+    return streaming();
+}
+
+bool ImageCache::streaming() const {
+    for (const auto& i : mEntries)
+        if (i.scaling != 0 || !i.pendingImage.isNull())
+            return true;
+    return false;
+}
+
+QVector<int> ImageCache::takeStreamed() {
+    QVector<int> streamed;
+    streamed.swap(mStreamed);
+    return streamed;
+}
+
+void ImageCache::scaled(int ticket, const QImage& image) {
+    for (auto& i : mEntries) {
+        if (i.scaling != ticket) continue;
+
+        i.scaling = 0;
+        i.pendingImage = image;
+        i.pendingRows = 0;
+        return;
+    }
+}
+
+void ImageCache::upload(Entry& entry, int level, Qt::TransformationMode mode) {
+    release(entry);
+
+    const auto image = levelImage(entry.image, level, mode);
+
+    entry.texture = new Texture(mState, image.width(), image.height(), image.constBits());
+    entry.texture->generateMipmaps();
+    entry.level = level;
+    mResident += textureBytes(image.width(), image.height());
+}
+
+void ImageCache::request(Entry& entry, int level) {
+    if ((entry.scaling != 0 || !entry.pendingImage.isNull()) && entry.pendingLevel <= level) return;
+    cancel(entry);
+
+    entry.pendingLevel = level;
+    entry.pendingRows = 0;
+
+    // the full level needs no filtering, only streaming
+    if (level == 0)
+        entry.pendingImage = entry.image;
+    else
+        entry.scaling = mLoader.scale(entry.image, levelSize(entry.image, level));
+}
+
+void ImageCache::release(Entry& entry) {
+    if (entry.texture == nullptr) return;
+
+    const auto size = entry.texture->size();
+    mResident -= textureBytes(size.width(), size.height());
+
+    delete entry.texture;
+    entry.texture = nullptr;
+}
+
+void ImageCache::cancel(Entry& entry) {
+    // a level still being filtered is dropped once it arrives
+    entry.scaling = 0;
+
+    if (entry.pending != nullptr) {
+        mResident -= textureBytes(entry.pendingImage.width(), entry.pendingImage.height());
+
+        delete entry.pending;
+        entry.pending = nullptr;
+    }
+
+    entry.pendingImage = QImage();
+}
@@ -0,0 +1,96 @@
+/*
+ * Jaoned - an OpenGL & QT based drawing board
+ * Copyright (C) 2024 Vadim Nikolaev (https://github.com/vadniks).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "defs.hpp"
+#include "Texture.hpp"
+#include "GlState.hpp"
+#include "ImageLoader.hpp"
+#include <QHash>
+#include <QImage>
+#include <QVector>
+#include <glm/glm.hpp>
+
+// Keeps the pixels of every committed image, identical ones stored once and shared by reference count, in memory and only some of them on the GPU, each at the mip level
+// its on-screen size calls for. Whatever isn't needed for the current frame may be dropped to a lower level
+// or evicted entirely to stay within the budget, and gets streamed back on the next request. Levels are filtered on a worker pool and then uploaded
+// a few rows at a time between frames, what is asked for meanwhile is drawn from the level already resident or a coarse preview
+class ImageCache final {
+private:
+    struct Entry {
+        QImage image; // RGBA8888
+        size_t hash;
+        int references;
+        Texture* texture; // nullable, evicted
+        int level; // of the resident texture relative to the image
+        int neededLevel;
+        qint64 lastUse;
+        Texture* pending; // nullable, another level being streamed in
+        QImage pendingImage; // of the pending level, null until filtered
+        int pendingLevel;
+        int pendingRows; // uploaded so far
+        int scaling; // ticket of the pending level being filtered, 0 if none
+    };
+
+    GlState& mState;
+    QHash<int, Entry> mEntries;
+    QHash<size_t, int> mHandleOfHash;
+    int mNextHandle;
+    qint64 mBudget;
+    qint64 mResident;
+    qint64 mFrame;
+    int mEvictions;
+    bool mStreaming;
+    QVector<int> mStreamed;
+    ImageLoader mLoader;
+    bool mReport;
+public:
+    static inline qint64 DEFAULT_BUDGET = 256ll * 1024 * 1024;
+    static inline int PREVIEW_SIZE = 64; // largest side of the level uploaded at once while a finer one streams in
+public:
+    explicit ImageCache(GlState& state);
+    ~ImageCache();
+
+    DISABLE_COPY(ImageCache)
+    DISABLE_MOVE(ImageCache)
+
+    static size_t contentHash(const QImage& image);
+    int acquire(const QImage& image, size_t hash);
+    int add(const QImage& image, size_t hash, Texture* /*nullable*/ texture);
+    void remove(int handle);
+    void clear();
+    const QImage& image(int handle) const;
+    size_t hash(int handle) const;
+    Texture& texture(int handle, const glm::vec2& displaySize);
+    void beginFrame();
+    void endFrame();
+    void setBudget(qint64 bytes);
+    qint64 budget() const;
+    qint64 residentBytes() const;
+    void setStreaming(bool enabled); // when off, whatever is asked for is uploaded right away
+    bool stream(qint64 bytes); // whether anything is left to stream
+    bool streaming() const;
+    QVector<int> takeStreamed(); // handles whose finer level arrived since the last call
+private:
+    void scaled(int ticket, const QImage& image);
+    void upload(Entry& entry, int level, Qt::TransformationMode mode);
+    void request(Entry& entry, int level);
+    void release(Entry& entry);
+    void cancel(Entry& entry);
+};
@@ -0,0 +1,72 @@
+/*
+ * Jaoned - an OpenGL & QT based drawing board
+ * Copyright (C) 2024 Vadim Nikolaev (https://github.com/vadniks).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "ImageLoader.hpp"
+#include "ImageCache.hpp"
+#include <QImageReader>
+
+ImageLoader::ImageLoader() : mPool(), mLastTicket(0) {}
+
+ImageLoader::~ImageLoader() {
+    mPool.clear();
+    mPool.waitForDone();
+}
+
+QSize ImageLoader::decodedSize(const QSize& source, const QSize& limit) {
+    if (source.width() <= limit.width() && source.height() <= limit.height())
+        return source;
+    return source.scaled(limit, Qt::AspectRatioMode::KeepAspectRatio);
+}
+
+// Qt's smooth scaler hands RGBA8888 back as premultiplied BGRA while the textures take straight RGBA
+QImage ImageLoader::resized(const QImage& image, const QSize& size, Qt::TransformationMode mode) {
+    return image.scaled(size, Qt::AspectRatioMode::IgnoreAspectRatio, mode).convertToFormat(QImage::Format::Format_RGBA8888);
+}
+
+int ImageLoader::load(const QString& path, const QSize& size) {
+    const int ticket = ++mLastTicket;
+
+    mPool.start([this, ticket, path, size](){
+        QImageReader reader(path);
+        reader.setAutoTransform(true);
+        if (reader.size() != size)
+            reader.setScaledSize(size);
+
+        QImage image;
+        if (!reader.read(&image)) {
+            emit failed(ticket);
+            return;
+        }
+
+        image = std::move(image).convertToFormat(QImage::Format::Format_RGBA8888);
+        const auto hash = ImageCache::contentHash(image);
+        emit loaded(ticket, image, hash);
+    });
+
+    return ticket;
+}
+
+int ImageLoader::scale(const QImage& image, const QSize& size) {
+    const int ticket = ++mLastTicket;
+
+    mPool.start([this, ticket, image, size](){
+        emit scaled(ticket, resized(image, size, Qt::TransformationMode::SmoothTransformation));
+    });
+
+    return ticket;
+}
@@ -0,0 +1,51 @@
+/*
+ * Jaoned - an OpenGL & QT based drawing board
+ * Copyright (C) 2024 Vadim Nikolaev (https://github.com/vadniks).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "defs.hpp"
+#include <QObject>
+#include <QThreadPool>
+#include <QImage>
+#include <QSize>
+#include <QString>
+
+// Decodes images on its own worker pool, reading large ones straight at a reduced size,
+// and hands them back as RGBA8888 along with their content hash to whoever listens on the GUI thread.
+// Filters decoded ones down to other sizes on the same pool
+class ImageLoader final : public QObject {
+    Q_OBJECT
+private:
+    QThreadPool mPool;
+    int mLastTicket;
+public:
+    ImageLoader();
+    ~ImageLoader() override;
+
+    DISABLE_COPY(ImageLoader)
+    DISABLE_MOVE(ImageLoader)
+
+    static QSize decodedSize(const QSize& source, const QSize& limit);
+    static QImage resized(const QImage& image, const QSize& size, Qt::TransformationMode mode);
+    int load(const QString& path, const QSize& size);
+    int scale(const QImage& image, const QSize& size);
+signals:
+    void loaded(int ticket, QImage image, size_t hash);
+    void failed(int ticket);
+    void scaled(int ticket, QImage image);
+};
@@ -0,0 +1,243 @@
+/*
+ * Jaoned - an OpenGL & QT based drawing board
+ * Copyright (C) 2024 Vadim Nikolaev (https://github.com/vadniks).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "Journal.hpp"
+#include <QDir>
+#include <QMutexLocker>
+#include <QDebug>
+#include <cstring>
+#include <unistd.h>
+#include <fcntl.h>
+#include <zlib.h>
+
+struct RecordHeader {
+    quint32 size; // of the data, padded to four bytes after it
+    quint32 checksum; // of the operation and the data
+    quint8 operation;
+    quint8 reserved[3];
+};
+
+static_assert(sizeof(RecordHeader) == 12);
+
+static quint32 checksum(Journal::Operation operation, const uchar* data, qint64 size) {
+    const auto tag = static_cast<uchar>(operation);
+    auto crc = crc32(0, &tag, 1);
+    return static_cast<quint32>(crc32_z(crc, data, static_cast<size_t>(size)));
+}
+
+static qint64 padded(qint64 bytes) {
+    return (bytes + 3) & ~3ll;
+}
+
+// a crash may leave a partly written batch or zeroes past the last record, anything else is damage to keep away from
+static bool tornTail(const uchar* data, qint64 offset, qint64 end, qint64 size) {
+    if (end >= size) return true;
+    for (qint64 i = offset; i < size; i++)
+        if (data[i] != 0) return false;
+    return true;
+}
+
+// of a file or a directory, QFile won't open the latter
+static void sync(const QString& path) {
+    const int descriptor = ::open(QFile::encodeName(path).constData(), O_RDONLY);
+    if (descriptor < 0) return;
+
+    fsync(descriptor);
+    close(descriptor);
+}
+
+static const char* const SET_ASIDE_SUFFIX = ".corrupt";
+
+Journal::Journal(const QString& directory) :
+    mDirectory(directory),
+    mGeneration(0),
+    mFile(),
+    mMutex(),
+    mPending(),
+    mFlushing(false),
+    mPool()
+{
+    mPool.setMaxThreadCount(1);
+
+    QDir dir(mDirectory);
+    dir.mkpath(".");
+
+    // the newest generation wins, an older one may still be around if the last rotation got interrupted
+    for (const auto& i : dir.entryList({"snapshot-*.jbrd", "journal-*"}, QDir::Filter::Files)) {
+        if (i.endsWith(SET_ASIDE_SUFFIX)) continue;
+
+        bool ok = false;
+        const int generation = i.section('-', 1).section('.', 0, 0).toInt(&ok);
+        if (ok) mGeneration = qMax(mGeneration, generation);
+    }
+
+    mFile.setFileName(journalPath(mGeneration));
+    open();
+}
+
+Journal::~Journal() {
+    flush();
+}
+
+bool Journal::replay(const std::function<bool (const QString& snapshot)>& open, const std::function<bool (Operation operation, const uchar* data, qint64 size)>& apply) {
+    flush();
+
+    const auto snapshot = snapshotPath(mGeneration);
+    if (QFile::exists(snapshot) && !open(snapshot)) return false;
+
+    QFile file(journalPath(mGeneration));
+    if (!file.open(QIODevice::ReadOnly) || file.size() == 0) return true;
+
+    const auto* data = file.map(0, file.size());
+    if (data == nullptr) return false;
+
+    qint64 offset = 0;
+    while (file.size() - offset >= static_cast<qint64>(sizeof(RecordHeader))) {
+        RecordHeader header{};
+        memcpy(&header, data + offset, sizeof(RecordHeader));
+
+        const auto* payload = data + offset + sizeof(RecordHeader);
+        const qint64 end = offset + static_cast<qint64>(sizeof(RecordHeader)) + padded(header.size);
+
+        const auto operation = static_cast<Operation>(header.operation);
+        if (end > file.size() || header.operation > static_cast<quint8>(Operation::IMAGE) || checksum(operation, payload, header.size) != header.checksum) {
+            if (tornTail(data, offset, end, file.size())) break;
+            return false;
+        }
+
+        if (!apply(operation, payload, header.size)) return false;
+        offset = end;
+    }
+
+    // whatever follows the last intact record was torn by a crash, new records must not land behind it
+    if (offset < file.size())
+        mFile.resize(offset);
+
+    return true;
+}
+
+bool Journal::rotate(const std::function<bool (const QString& snapshot)>& save) {
+    flush();
+
+    const int next = mGeneration + 1;
+    if (!save(snapshotPath(next))) return false;
+    sync(snapshotPath(next));
+
+    mFile.close();
+    QFile::remove(journalPath(next));
+    mFile.setFileName(journalPath(next));
+    open();
+
+    // the new generation has to be on disk before the old one goes
+    sync(mDirectory);
+
+    QFile::remove(snapshotPath(mGeneration));
+    QFile::remove(journalPath(mGeneration));
+    mGeneration = next;
+
+    return true;
+}
+
+bool Journal::setAside() {
+    flush();
+    mFile.close();
+
+    for (const auto& i : {snapshotPath(mGeneration), journalPath(mGeneration)}) {
+        if (!QFile::exists(i)) continue;
+
+        QFile::remove(i + SET_ASIDE_SUFFIX);
+        if (!QFile::rename(i, i + SET_ASIDE_SUFFIX)) {
+            qWarning() << "journal: cannot set aside" << i;
+            return false;
+        }
+        qWarning() << "journal: kept" << i + SET_ASIDE_SUFFIX;
+    }
+
+    sync(mDirectory);
+    mFile.setFileName(journalPath(mGeneration));
+    open();
+    return true;
+}
+
+void Journal::append(Operation operation, const QByteArray& data) {
+    append(operation, [data](){ return data; });
+}
+
+void Journal::append(Operation operation, const std::function<QByteArray ()>& encode) {
+    QMutexLocker locker(&mMutex);
+    mPending.push_back({operation, encode});
+
+    if (mFlushing) return;
+    mFlushing = true;
+    mPool.start([this](){ write(); });
+}
+
+void Journal::flush() {
+    mPool.waitForDone();
+}
+
+bool Journal::isOpen() const {
+    return mFile.isOpen();
+}
+
+QString Journal::snapshotPath(int generation) const {
+    return QDir(mDirectory).filePath(QString("snapshot-%1.jbrd").arg(generation));
+}
+
+QString Journal::journalPath(int generation) const {
+    return QDir(mDirectory).filePath(QString("journal-%1").arg(generation));
+}
+
+void Journal::open() {
+    if (!mFile.open(QIODevice::WriteOnly | QIODevice::Append))
+        qWarning() << "journal: cannot open" << mFile.fileName() << "-" << mFile.errorString();
+}
+
+void Journal::write() {
+    // everything appended while the previous batch was being written goes out as the next one
+    while (true) {
+        QVector<Record> records;
+        {
+            QMutexLocker locker(&mMutex);
+            if (mPending.isEmpty()) {
+                mFlushing = false;
+                return;
+            }
+            records.swap(mPending);
+        }
+
+        // with no file there is nowhere to put them, the failure was reported when opening
+        if (!mFile.isOpen()) continue;
+
+        QByteArray batch;
+        for (const auto& i : records) {
+            const auto xData = i.encode();
+            const auto* data = reinterpret_cast<const uchar*>(xData.constData());
+            const RecordHeader header{static_cast<quint32>(xData.size()), checksum(i.operation, data, xData.size()), static_cast<quint8>(i.operation), {}};
+
+            batch.append(reinterpret_cast<const char*>(&header), sizeof(RecordHeader));
+            batch.append(xData);
+            batch.append(padded(xData.size()) - xData.size(), '\0');
+        }
+
+        // records count as written once they're on the disk, not in the page cache
+        mFile.write(batch);
+        mFile.flush();
+        fdatasync(mFile.handle());
+    }
+}
@@ -0,0 +1,76 @@
+/*
+ * Jaoned - an OpenGL & QT based drawing board
+ * Copyright (C) 2024 Vadim Nikolaev (https://github.com/vadniks).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "defs.hpp"
+#include <functional>
+#include <QString>
+#include <QByteArray>
+#include <QVector>
+#include <QFile>
+#include <QMutex>
+#include <QThreadPool>
+
+// Append-only log of board operations since the last snapshot, written by a background thread.
+// Every record carries a checksum, so a torn tail left by a crash ends the replay instead of corrupting it.
+// Generations pair a snapshot with the journal on top of it, a new one is complete before the old one goes away
+class Journal final {
+public:
+    enum class Operation : uchar {
+        COMMIT, // data is a document holding the committed element
+        UNDO,
+        CLEAR,
+        REDO,
+        ERASE, // data is the eraser width followed by its path
+        BLOB, // data is an image's size and content hash followed by its RGBA pixels
+        IMAGE // data is the content hash of an earlier blob and where the image is placed
+    };
+private:
+    struct Record {
+        Operation operation;
+        std::function<QByteArray ()> encode; // produces the data, on the writer thread
+    };
+private:
+    QString mDirectory;
+    int mGeneration;
+    QFile mFile; // used only by the pool
+    QMutex mMutex;
+    QVector<Record> mPending; // guarded by the mutex
+    bool mFlushing; // guarded by the mutex
+    QThreadPool mPool;
+public:
+    explicit Journal(const QString& directory);
+    ~Journal();
+
+    DISABLE_COPY(Journal)
+    DISABLE_MOVE(Journal)
+
+    bool replay(const std::function<bool (const QString& snapshot)>& open, const std::function<bool (Operation operation, const uchar* data, qint64 size)>& apply);
+    bool rotate(const std::function<bool (const QString& snapshot)>& save);
+    bool setAside(); // the current generation, renamed so that nothing deletes it, and starts over with an empty journal
+    void append(Operation operation, const QByteArray& data = QByteArray());
+    void append(Operation operation, const std::function<QByteArray ()>& encode);
+    void flush();
+    bool isOpen() const;
+private:
+    QString snapshotPath(int generation) const;
+    QString journalPath(int generation) const;
+    void open();
+    void write();
+};
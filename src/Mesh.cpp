@@ -0,0 +1,64 @@
+/*
+ * Jaoned - an OpenGL & QT based drawing board
+ * Copyright (C) 2024 Vadim Nikolaev (https://github.com/vadniks).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "Mesh.hpp"
+
+Mesh::Mesh(GlState& state, const QVector<float>& vertices, int primitive) :
+    mState(state),
+    mGl(state.gl()),
+    mVbo(0),
+    mVao(0),
+    mCount(static_cast<int>(vertices.size() / 2)),
+    mPrimitive(primitive)
+{
+    mGl.glGenVertexArrays(1, &mVao);
+    mGl.glGenBuffers(1, &mVbo);
+
+    mState.bindVertexArray(mVao);
+    mState.bindBuffer(GL_ARRAY_BUFFER, mVbo);
+    mState.countBufferData(static_cast<long>(vertices.size() * sizeof(float)));
+    mGl.glBufferData(GL_ARRAY_BUFFER, static_cast<long>(vertices.size() * sizeof(float)), vertices.data(), GL_STATIC_DRAW);
+
+    mGl.glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), reinterpret_cast<void*>(0));
+    mGl.glEnableVertexAttribArray(0);
+
+    mState.bindVertexArray(0);
+}
+
+Mesh::~Mesh() {
+    mState.forgetBuffer(mVbo);
+    mState.forgetVertexArray(mVao);
+    mGl.glDeleteBuffers(1, &mVbo);
+    mGl.glDeleteVertexArrays(1, &mVao);
+}
+
+void Mesh::draw() {
+    if (mCount == 0) return;
+
+    mState.bindVertexArray(mVao);
+    mState.countDraw();
+    mGl.glDrawArrays(mPrimitive, 0, mCount);
+}
+
+int Mesh::count() const {
+    return mCount;
+}
+
+int Mesh::primitive() const {
+    return mPrimitive;
+}
@@ -0,0 +1,44 @@
+/*
+ * Jaoned - an OpenGL & QT based drawing board
+ * Copyright (C) 2024 Vadim Nikolaev (https://github.com/vadniks).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "defs.hpp"
+#include "GlState.hpp"
+#include <QOpenGLFunctions_3_3_Core>
+#include <QVector>
+
+// GPU-resident list of 2d vertices, uploaded once and drawn as many times as needed with the given primitive
+class Mesh final {
+private:
+    GlState& mState;
+    QOpenGLFunctions_3_3_Core& mGl;
+    unsigned mVbo, mVao;
+    int mCount;
+    int mPrimitive;
+public:
+    Mesh(GlState& state, const QVector<float>& vertices, int primitive = GL_TRIANGLES);
+    ~Mesh();
+
+    DISABLE_COPY(Mesh)
+    DISABLE_MOVE(Mesh)
+
+    void draw();
+    int count() const;
+    int primitive() const;
+};
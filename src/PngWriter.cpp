@@ -0,0 +1,88 @@
+/*
+ * Jaoned - an OpenGL & QT based drawing board
+ * Copyright (C) 2024 Vadim Nikolaev (https://github.com/vadniks).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "PngWriter.hpp"
+#include <QFile>
+
+PngWriter::PngWriter(const QString& path, int width, int height, int dpi) :
+    mFile(fopen(QFile::encodeName(path).constData(), "wb")),
+    mPng(png_create_write_struct(PNG_LIBPNG_VER_STRING, nullptr, nullptr, nullptr)),
+    mInfo(nullptr),
+    mWidth(width),
+    mHeight(height),
+    mRows(0),
+    mFailed(mFile == nullptr)
+{
+    assert(width > 0 && height > 0);
+    assert(mPng != nullptr);
+    mInfo = png_create_info_struct(mPng);
+    assert(mInfo != nullptr);
+
+    if (mFailed) return;
+
+    if (setjmp(png_jmpbuf(mPng)) != 0) {
+        mFailed = true;
+        return;
+    }
+
+    png_init_io(mPng, mFile);
+    png_set_IHDR(mPng, mInfo, static_cast<unsigned>(width), static_cast<unsigned>(height), 8,
+        PNG_COLOR_TYPE_RGB_ALPHA, PNG_INTERLACE_NONE, PNG_COMPRESSION_TYPE_DEFAULT, PNG_FILTER_TYPE_DEFAULT);
+
+    if (dpi > 0) {
+        const auto dotsPerMeter = static_cast<unsigned>(static_cast<double>(dpi) / 0.0254 + 0.5);
+        png_set_pHYs(mPng, mInfo, dotsPerMeter, dotsPerMeter, PNG_RESOLUTION_METER);
+    }
+    png_write_info(mPng, mInfo);
+}
+
+PngWriter::~PngWriter() {
+    png_destroy_write_struct(&mPng, &mInfo);
+    if (mFile != nullptr) fclose(mFile);
+}
+
+void PngWriter::writeRows(const uchar* rows, int count) {
+    assert(mRows + count <= mHeight);
+    if (mFailed) return;
+
+    if (setjmp(png_jmpbuf(mPng)) != 0) {
+        mFailed = true;
+        return;
+    }
+
+    for (int i = 0; i < count; i++)
+        png_write_row(mPng, rows + static_cast<qint64>(i) * mWidth * 4);
+    mRows += count;
+}
+
+bool PngWriter::finish() {
+    if (mFailed || mRows != mHeight) return false;
+
+    if (setjmp(png_jmpbuf(mPng)) != 0)
+        return false;
+
+    png_write_end(mPng, nullptr);
+
+    const bool closed = fclose(mFile) == 0;
+    mFile = nullptr;
+    return closed;
+}
+
+int PngWriter::rows() const {
+    return mRows;
+}
@@ -0,0 +1,46 @@
+/*
+ * Jaoned - an OpenGL & QT based drawing board
+ * Copyright (C) 2024 Vadim Nikolaev (https://github.com/vadniks).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "defs.hpp"
+#include <QString>
+#include <cstdio>
+#include <png.h>
+
+// Encodes an RGBA8888 image into a PNG file row by row, so the whole image never has to be in memory at once.
+// Any failure makes the writer ignore further rows and finish() report false
+class PngWriter final {
+private:
+    FILE* mFile; // nullable
+    png_structp mPng;
+    png_infop mInfo;
+    int mWidth, mHeight;
+    int mRows;
+    bool mFailed;
+public:
+    PngWriter(const QString& path, int width, int height, int dpi = 0);
+    ~PngWriter();
+
+    DISABLE_COPY(PngWriter)
+    DISABLE_MOVE(PngWriter)
+
+    void writeRows(const uchar* rows, int count); // tightly packed, top first
+    bool finish();
+    int rows() const;
+};
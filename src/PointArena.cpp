@@ -0,0 +1,92 @@
+/*
+ * Jaoned - an OpenGL & QT based drawing board
+ * Copyright (C) 2024 Vadim Nikolaev (https://github.com/vadniks).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "PointArena.hpp"
+
+PointArena::PointArena() : mChunks(), mTop(0) {}
+
+PointArena::~PointArena() {
+    for (const auto& i : mChunks)
+        delete[] i.points;
+}
+
+glm::vec2* PointArena::allocate(int count) {
+    assert(count > 0);
+
+    if (!mChunks.isEmpty() && mChunks[mTop].capacity - mChunks[mTop].used >= count) {
+        auto& chunk = mChunks[mTop];
+        auto* run = chunk.points + chunk.used;
+        chunk.used += count;
+        return run;
+    }
+
+    // the top chunk is only ever empty when it's the first one
+    const int next = mChunks.isEmpty() || mChunks[mTop].used == 0 ? mTop : mTop + 1;
+
+    const int capacity = glm::max(CHUNK_POINTS, count);
+    if (next == mChunks.size())
+        mChunks.push_back({new glm::vec2[capacity], capacity, 0});
+    else if (mChunks[next].capacity < count) {
+        delete[] mChunks[next].points;
+        mChunks[next] = {new glm::vec2[capacity], capacity, 0};
+    }
+
+    mTop = next;
+    mChunks[mTop].used = count;
+    return mChunks[mTop].points;
+}
+
+void PointArena::release(const glm::vec2* run) {
+    auto& chunk = mChunks[mTop];
+    assert(run >= chunk.points && run < chunk.points + chunk.used);
+
+    chunk.used = static_cast<int>(run - chunk.points);
+    if (chunk.used > 0 || mTop == 0) return;
+
+    // the emptied chunk stays as the spare, so popping and pushing across a boundary doesn't allocate
+    mTop--;
+    while (mChunks.size() > mTop + 2) {
+        delete[] mChunks.last().points;
+        mChunks.removeLast();
+    }
+}
+
+void PointArena::clear() {
+    // the first chunk is kept for whatever comes next
+    while (mChunks.size() > 1) {
+        delete[] mChunks.last().points;
+        mChunks.removeLast();
+    }
+
+    if (!mChunks.isEmpty()) mChunks.first().used = 0;
+    mTop = 0;
+}
+
+qint64 PointArena::reservedBytes() const {
+    qint64 bytes = 0;
+    for (const auto& i : mChunks)
+        bytes += static_cast<qint64>(i.capacity) * sizeof(glm::vec2);
+    return bytes;
+}
+
+qint64 PointArena::usedBytes() const {
+    qint64 bytes = 0;
+    for (int i = 0; i <= mTop && i < mChunks.size(); i++)
+        bytes += static_cast<qint64>(mChunks[i].used) * sizeof(glm::vec2);
+    return bytes;
+}
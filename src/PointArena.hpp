@@ -0,0 +1,51 @@
+/*
+ * Jaoned - an OpenGL & QT based drawing board
+ * Copyright (C) 2024 Vadim Nikolaev (https://github.com/vadniks).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "defs.hpp"
+#include <QVector>
+#include <glm/glm.hpp>
+
+// Stack of point runs in fixed-size chunks that never move, so growing copies nothing already stored.
+// A run never straddles two chunks and stays contiguous, one larger than a chunk gets a chunk of its own
+class PointArena final {
+private:
+    struct Chunk {
+        glm::vec2* points; // owned
+        int capacity;
+        int used;
+    };
+
+    QVector<Chunk> mChunks; // up to the top one, plus one emptied spare above it
+    int mTop;
+public:
+    static inline int CHUNK_POINTS = 64 * 1024;
+public:
+    PointArena();
+    ~PointArena();
+
+    DISABLE_COPY(PointArena)
+    DISABLE_MOVE(PointArena)
+
+    glm::vec2* allocate(int count);
+    void release(const glm::vec2* run); // the last allocated one
+    void clear();
+    qint64 reservedBytes() const;
+    qint64 usedBytes() const;
+};
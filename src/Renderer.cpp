@@ -19,11 +19,12 @@
 #include "Renderer.hpp"
 #include <QSize>
 #include <glm/ext/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
 
 static const char* const gShapeVertexShader = R"(
     #version 330 core
     layout (location = 0) in vec2 pos;
-    uniform mat4 projection;
+    layout (std140) uniform Projection { mat4 projection; };
     void main() {
         gl_Position = projection * vec4(pos, 0.0, 1.0);
     }
@@ -43,7 +44,7 @@ static const char* const gSpriteVertexShader = R"(
     layout (location = 0) in vec4 vertex;
     out vec2 textureCoords;
     uniform mat4 model;
-    uniform mat4 projection;
+    layout (std140) uniform Projection { mat4 projection; };
     void main() {
         textureCoords = vertex.zw;
         gl_Position = projection * model * vec4(vertex.xy, 0.0, 1.0);
@@ -57,197 +58,303 @@ static const char* const gSpriteFragmentShader = R"(
     uniform sampler2D sprite;
     uniform vec4 spriteColor;
     uniform int isMono;
+    uniform int isDistance;
     void main() {
         if (isMono == 0)
             color = spriteColor * texture(sprite, textureCoords);
         else {
-            vec4 sampled = texture(sprite, textureCoords);
-            color = spriteColor * vec4(sampled.r, sampled.r, sampled.r, sampled.r);
+            float coverage = texture(sprite, textureCoords).r;
+            if (isDistance != 0) {
+                // the edge sits at the middle of the range, fwidth keeps it about a pixel wide at any scale
+                float edge = fwidth(coverage) * 0.75;
+                coverage = smoothstep(0.5 - edge, 0.5 + edge, coverage);
+            }
+            color = spriteColor * vec4(coverage, coverage, coverage, coverage);
         }
     }
 )";
 
+static const char* const gStrokeVertexShader = R"(
+    #version 330 core
+    layout (location = 0) in vec2 pos;
+    void main() {
+        gl_Position = vec4(pos, 0.0, 1.0);
+    }
+)";
+
+// expands every segment of a line strip with adjacency into a quad, round joins and caps are discs
+// emitted as zig-zag strips around the segment start, and around the end of the last segment
+static const char* const gStrokeGeometryShader = R"(
+    #version 330 core
+    layout (lines_adjacency) in;
+    layout (triangle_strip, max_vertices = 68) out;
+    layout (std140) uniform Projection { mat4 projection; };
+    uniform float width;
+    const int SEGMENTS = 32;
+
+    void emit(vec2 position) {
+        gl_Position = projection * vec4(position, 0.0, 1.0);
+        EmitVertex();
+    }
+
+    void disc(vec2 center, float radius) {
+        emit(center + vec2(radius, 0.0));
+        for (int i = 1; i <= SEGMENTS / 2; i++) {
+            float angle = 6.28318530718 * float(i) / float(SEGMENTS);
+            emit(center + radius * vec2(cos(angle), sin(angle)));
+            if (i < SEGMENTS / 2)
+                emit(center + radius * vec2(cos(angle), -sin(angle)));
+        }
+        EndPrimitive();
+    }
+
+    void main() {
+        vec2 previous = gl_in[0].gl_Position.xy;
+        vec2 start = gl_in[1].gl_Position.xy;
+        vec2 end = gl_in[2].gl_Position.xy;
+        vec2 next = gl_in[3].gl_Position.xy;
+        float radius = width * 0.5;
+        vec2 direction = end - start;
+
+        if (dot(direction, direction) > 0.0) {
+            vec2 normal = normalize(vec2(-direction.y, direction.x)) * radius;
+            emit(start - normal);
+            emit(start + normal);
+            emit(end - normal);
+            emit(end + normal);
+            EndPrimitive();
+        }
+
+        vec2 incoming = start - previous;
+        bool straight = dot(incoming, incoming) > 0.0 && dot(direction, direction) > 0.0
+            && dot(normalize(incoming), normalize(direction)) > 0.9999;
+        if (!straight) disc(start, radius);
+        if (next == end) disc(end, radius);
+    }
+)";
+
+static const float gUnitQuad[] = {
+    0.0f, 1.0f, 0.0f, 1.0f,
+    1.0f, 0.0f, 1.0f, 0.0f,
+    0.0f, 0.0f, 0.0f, 0.0f,
+
+    0.0f, 1.0f, 0.0f, 1.0f,
+    1.0f, 1.0f, 1.0f, 1.0f,
+    1.0f, 0.0f, 1.0f, 0.0f
+};
+
 static const char* FONT_FILE = "res/Roboto-Regular.ttf";
-static const char* PROJECTION = "projection";
+static const char* PROJECTION_BLOCK = "Projection";
+static const unsigned PROJECTION_BINDING = 0;
 static const char* COLOR = "color";
 static const char* MODEL = "model";
 static const char* SPRITE_COLOR = "spriteColor";
 static const char* IS_MONO = "isMono";
+static const char* IS_DISTANCE = "isDistance";
+static const char* STROKE_WIDTH = "width";
+
+static void addQuad(QVector<float>& vertices, const glm::vec2& positionStart, const glm::vec2& positionEnd, float lineWidth) {
+    if (positionStart == positionEnd) return;
+
+    const glm::vec2 normal = glm::normalize(glm::vec2(positionStart.y - positionEnd.y, positionEnd.x - positionStart.x)) * (lineWidth * 0.5f);
+
+    const glm::vec2 c1 = positionStart - normal;
+    const glm::vec2 c2 = positionStart + normal;
+    const glm::vec2 c3 = positionEnd - normal;
+    const glm::vec2 c4 = positionEnd + normal;
+
+    vertices.append({
+        c1.x, c1.y, c2.x, c2.y, c4.x, c4.y,
+        c4.x, c4.y, c1.x, c1.y, c3.x, c3.y
+    });
+}
+
+// the strip repeats its first and last points as their own neighbours, which marks where the caps go
+static QVector<float> strokeVertices(const QVector<glm::vec2>& points) {
+    QVector<float> vertices;
+    if (points.isEmpty()) return vertices;
+
+    vertices.reserve(static_cast<long>(points.size() + 3) * 2);
+    vertices.append({points.first().x, points.first().y});
+    for (const auto& i : points)
+        vertices.append({i.x, i.y});
+    vertices.append({points.last().x, points.last().y});
+
+    if (points.size() == 1)
+        vertices.append({points.last().x, points.last().y});
+    return vertices;
+}
 
 Renderer::Renderer(QOpenGLFunctions_3_3_Core& gl) :
     mGl(gl),
-    mVbo(0),
-    mEbo(0),
-    mVao(0),
-    mProjection(1.0f),
+    mState(gl),
+    mProfiler(gl),
+    mShapeVbo(0),
+    mShapeVao(0),
+    mQuadVbo(0),
+    mQuadVao(0),
+    mTextVbo(0),
+    mTextVao(0),
+    mProjectionUbo(0),
+    mShapeColor(),
+    mSpriteModel(),
+    mSpriteColor(),
+    mSpriteIsMono(),
+    mSpriteIsDistance(),
+    mStrokeWidth(),
+    mStrokeColor(),
     mFtLib(),
-    mFtFace()
+    mFtFace(),
+    mGlyphAtlas(nullptr),
+    mTextLayout(nullptr)
 {
-    mShapeShader = new CompoundShader(gl, gShapeVertexShader, gShapeFragmentShader);
-    mSpriteShader = new CompoundShader(gl, gSpriteVertexShader, gSpriteFragmentShader);
-    mGl.glGenBuffers(1, &mVbo);
-    mGl.glGenBuffers(1, &mEbo);
-    mGl.glGenVertexArrays(1, &mVao);
+    mShapeShader = new CompoundShader(mState, gShapeVertexShader, gShapeFragmentShader);
+    mSpriteShader = new CompoundShader(mState, gSpriteVertexShader, gSpriteFragmentShader);
+    mStrokeShader = new CompoundShader(mState, gStrokeVertexShader, gStrokeGeometryShader, gShapeFragmentShader);
+
+    mShapeColor = mShapeShader->uniform<glm::vec4>(COLOR);
+    mSpriteModel = mSpriteShader->uniform<glm::mat4>(MODEL);
+    mSpriteColor = mSpriteShader->uniform<glm::vec4>(SPRITE_COLOR);
+    mSpriteIsMono = mSpriteShader->uniform<int>(IS_MONO);
+    mSpriteIsDistance = mSpriteShader->uniform<int>(IS_DISTANCE);
+    mStrokeWidth = mStrokeShader->uniform<float>(STROKE_WIDTH);
+    mStrokeColor = mStrokeShader->uniform<glm::vec4>(COLOR);
+
+    mShapeShader->bindUniformBlock(PROJECTION_BLOCK, PROJECTION_BINDING);
+    mSpriteShader->bindUniformBlock(PROJECTION_BLOCK, PROJECTION_BINDING);
+    mStrokeShader->bindUniformBlock(PROJECTION_BLOCK, PROJECTION_BINDING);
+
+    const glm::mat4 identity(1.0f);
+    mGl.glGenBuffers(1, &mProjectionUbo);
+    mState.bindBuffer(GL_UNIFORM_BUFFER, mProjectionUbo);
+    mState.countBufferData(sizeof(glm::mat4));
+    mGl.glBufferData(GL_UNIFORM_BUFFER, sizeof(glm::mat4), glm::value_ptr(identity), GL_DYNAMIC_DRAW);
+    mGl.glBindBufferBase(GL_UNIFORM_BUFFER, PROJECTION_BINDING, mProjectionUbo);
+
+    // every vertex layout gets its own array object configured once, so drawing only binds it
+
+    mGl.glGenBuffers(1, &mShapeVbo);
+    mGl.glGenVertexArrays(1, &mShapeVao);
+    mState.bindVertexArray(mShapeVao);
+    mState.bindBuffer(GL_ARRAY_BUFFER, mShapeVbo);
+    mGl.glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), reinterpret_cast<void*>(0));
+    mGl.glEnableVertexAttribArray(0);
+
+    mGl.glGenBuffers(1, &mQuadVbo);
+    mGl.glGenVertexArrays(1, &mQuadVao);
+    mState.bindVertexArray(mQuadVao);
+    mState.bindBuffer(GL_ARRAY_BUFFER, mQuadVbo);
+    mState.countBufferData(sizeof(gUnitQuad));
+    mGl.glBufferData(GL_ARRAY_BUFFER, sizeof(gUnitQuad), gUnitQuad, GL_STATIC_DRAW);
+    mGl.glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 4 * sizeof(float), reinterpret_cast<void*>(0));
+    mGl.glEnableVertexAttribArray(0);
+
+    mGl.glGenBuffers(1, &mTextVbo);
+    mGl.glGenVertexArrays(1, &mTextVao);
+    mState.bindVertexArray(mTextVao);
+    mState.bindBuffer(GL_ARRAY_BUFFER, mTextVbo);
+    mGl.glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 4 * sizeof(float), reinterpret_cast<void*>(0));
+    mGl.glEnableVertexAttribArray(0);
+
+    mState.bindVertexArray(0);
 
     assert(FT_Init_FreeType(&mFtLib) == 0);
     assert(FT_New_Face(mFtLib, FONT_FILE, 0, &mFtFace) == 0);
+    mGlyphAtlas = new GlyphAtlas(mState, mFtFace);
+    mTextLayout = new TextLayout(*mGlyphAtlas, mFtFace);
 }
 
 Renderer::~Renderer() {
     delete mShapeShader;
     delete mSpriteShader;
-    mGl.glDeleteBuffers(1, &mVbo);
-    mGl.glDeleteBuffers(1, &mEbo);
-    mGl.glDeleteVertexArrays(1, &mVao);
+    delete mStrokeShader;
 
+    const unsigned buffers[] = {mShapeVbo, mQuadVbo, mTextVbo, mProjectionUbo};
+    for (auto i : buffers)
+        mState.forgetBuffer(i);
+    mGl.glDeleteBuffers(sizeof(buffers) / sizeof(unsigned), buffers);
+
+    const unsigned vertexArrays[] = {mShapeVao, mQuadVao, mTextVao};
+    for (auto i : vertexArrays)
+        mState.forgetVertexArray(i);
+    mGl.glDeleteVertexArrays(sizeof(vertexArrays) / sizeof(unsigned), vertexArrays);
+
+    delete mTextLayout;
+    delete mGlyphAtlas;
     assert(FT_Done_Face(mFtFace) == 0);
     assert(FT_Done_FreeType(mFtLib) == 0);
 }
 
+GlState& Renderer::state() {
+    return mState;
+}
+
+GpuProfiler& Renderer::profiler() {
+    return mProfiler;
+}
+
 void Renderer::setProjection(const glm::mat4& projection) {
-    mProjection = projection;
+    mState.bindBuffer(GL_UNIFORM_BUFFER, mProjectionUbo);
+    mState.countBufferData(sizeof(glm::mat4));
+    mGl.glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(glm::mat4), glm::value_ptr(projection));
 }
 
 void Renderer::drawPoint(const glm::vec2& position, float pointSize, const glm::vec4& color) {
-    mGl.glBindVertexArray(mVao);
-
+    ProfileScope scope(mProfiler, ProfilePhase::DRAW_SHAPE);
     const float vertices[] = {
         position[0], position[1]
     };
 
-    mGl.glBindBuffer(GL_ARRAY_BUFFER, mVbo);
+    mState.bindVertexArray(mShapeVao);
+    mState.bindBuffer(GL_ARRAY_BUFFER, mShapeVbo);
+    mState.countBufferData(sizeof(vertices));
     mGl.glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_DYNAMIC_DRAW);
 
-    mGl.glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), reinterpret_cast<void*>(0));
-    mGl.glEnableVertexAttribArray(0);
-
     mShapeShader->use();
-    mShapeShader->setValue(PROJECTION, mProjection);
-    mShapeShader->setValue(COLOR, color);
+    mShapeShader->setValue(mShapeColor, color);
 
-    mGl.glPointSize(pointSize);
+    mState.setPointSize(pointSize);
+    mState.countDraw();
     mGl.glDrawArrays(GL_POINTS, 0, 1);
-
-    mGl.glBindBuffer(GL_ARRAY_BUFFER, 0);
-    mGl.glBindVertexArray(0);
 }
 
 void Renderer::drawPoints(int count, const QVector<float>& vertices, float pointSize, const glm::vec4& color, int drawMode) {
     assert(drawMode == GL_POINTS || drawMode == GL_TRIANGLES);
+    ProfileScope scope(mProfiler, ProfilePhase::DRAW_SHAPE);
 
-    mGl.glBindVertexArray(mVao);
-
-    mGl.glBindBuffer(GL_ARRAY_BUFFER, mVbo);
+    mState.bindVertexArray(mShapeVao);
+    mState.bindBuffer(GL_ARRAY_BUFFER, mShapeVbo);
+    mState.countBufferData(static_cast<long>(count * sizeof(float)));
     mGl.glBufferData(GL_ARRAY_BUFFER, static_cast<long>(count * sizeof(float)), vertices.data(), GL_DYNAMIC_DRAW);
 
-    mGl.glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), reinterpret_cast<void*>(0));
-    mGl.glEnableVertexAttribArray(0);
-
     mShapeShader->use();
-    mShapeShader->setValue(PROJECTION, mProjection);
-    mShapeShader->setValue(COLOR, color);
+    mShapeShader->setValue(mShapeColor, color);
 
-    mGl.glPointSize(pointSize);
+    mState.setPointSize(pointSize);
+    mState.countDraw();
     mGl.glDrawArrays(drawMode, 0, count);
-
-    mGl.glBindBuffer(GL_ARRAY_BUFFER, 0);
-    mGl.glBindVertexArray(0);
 }
 
 void Renderer::drawLine(const glm::vec2& positionStart, const glm::vec2& positionEnd, float lineWidth, const glm::vec4& color) {
-    const float dx = positionEnd.x - positionStart.x;
-    const float dy = positionEnd.y - positionStart.y;
-
-    glm::vec2 normal(-dy, dx);
-    normal = glm::normalize(normal);
-
-    normal.x *= lineWidth * 0.5f;
-    normal.y *= lineWidth * 0.5f;
-
-    const glm::vec2 c1 = positionStart - normal;
-    const glm::vec2 c2 = positionStart + normal;
-    const glm::vec2 c3 = positionEnd - normal;
-    const glm::vec2 c4 = positionEnd + normal;
-
-    mGl.glBindVertexArray(mVao);
-
-    const float vertices[] = {
-        c1.x, c1.y,
-        c2.x, c2.y,
-        c3.x, c3.y,
-        c4.x, c4.y,
-    };
-
-    mGl.glBindBuffer(GL_ARRAY_BUFFER, mVbo);
-    mGl.glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_DYNAMIC_DRAW);
-
-    mGl.glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), reinterpret_cast<void*>(0));
-    mGl.glEnableVertexAttribArray(0);
-
-    const unsigned indices[] = {
-        0, 1, 3,
-        3, 0, 2
-    };
-
-    mGl.glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mEbo);
-    mGl.glBufferData(
-        GL_ELEMENT_ARRAY_BUFFER,
-        sizeof(indices),
-        indices,
-        GL_DYNAMIC_DRAW
-    );
-
-    mShapeShader->use();
-    mShapeShader->setValue(PROJECTION, mProjection);
-    mShapeShader->setValue(COLOR, color);
-
-    mGl.glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, reinterpret_cast<void*>(0));
-
-    mGl.glBindBuffer(GL_ARRAY_BUFFER, 0);
-    mGl.glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
-    mGl.glBindVertexArray(0);
-}
-
-void Renderer::drawHollowCircle(const glm::vec2& positionCenter, int radius, const glm::vec4& color) {
-    int count = 0;
+    ProfileScope scope(mProfiler, ProfilePhase::DRAW_SHAPE);
     QVector<float> vertices;
+    addQuad(vertices, positionStart, positionEnd, lineWidth);
+    if (vertices.isEmpty()) return;
 
-    const auto addVertex = [&](float x, float y) {
-        count += 2;
-        vertices.resize(static_cast<long>(count * sizeof(float)));
-        vertices[count - 2] = positionCenter.x + x; vertices[count - 1] = positionCenter.y + y;
-    };
+    mState.bindVertexArray(mShapeVao);
+    mState.bindBuffer(GL_ARRAY_BUFFER, mShapeVbo);
+    mState.countBufferData(static_cast<long>(vertices.size() * sizeof(float)));
+    mGl.glBufferData(GL_ARRAY_BUFFER, static_cast<long>(vertices.size() * sizeof(float)), vertices.constData(), GL_DYNAMIC_DRAW);
 
-    float x, y;
-    for (int i = 0; i < 180; i++) {
-        x = static_cast<float>(radius) * cosf(static_cast<float>(i));
-        y = static_cast<float>(radius) * sinf(static_cast<float>(i));
-        addVertex(x, y);
-    }
+    mShapeShader->use();
+    mShapeShader->setValue(mShapeColor, color);
 
-    if (count > 0)
-        drawPoints(count, vertices, 1.0f, color, GL_TRIANGLES);
+    mState.countDraw();
+    mGl.glDrawArrays(GL_TRIANGLES, 0, static_cast<int>(vertices.size() / 2));
 }
 
 void Renderer::drawTexture(Texture& texture, const glm::vec2& position, const glm::vec2& size, float rotation, const glm::vec4& color, bool isMono) {
-    mGl.glBindVertexArray(mVao);
-
-    float vertices[] = {
-        0.0f, 1.0f, 0.0f, 1.0f,
-        1.0f, 0.0f, 1.0f, 0.0f,
-        0.0f, 0.0f, 0.0f, 0.0f,
-
-        0.0f, 1.0f, 0.0f, 1.0f,
-        1.0f, 1.0f, 1.0f, 1.0f,
-        1.0f, 0.0f, 1.0f, 0.0f
-    };
-
-    mGl.glBindBuffer(GL_ARRAY_BUFFER, mVbo);
-    mGl.glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_DYNAMIC_DRAW);
-
-    mGl.glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 4 * sizeof(float), reinterpret_cast<void*>(0));
-    mGl.glEnableVertexAttribArray(0);
-
+    ProfileScope scope(mProfiler, ProfilePhase::DRAW_TEXTURE);
     auto model = glm::mat4(1.0f);
     model = glm::translate(model, glm::vec3(position[0], position[1], 0.0f));
 
@@ -258,63 +365,123 @@ void Renderer::drawTexture(Texture& texture, const glm::vec2& position, const gl
     model = glm::scale(model, glm::vec3(size[0], size[1], 1.0f));
 
     mSpriteShader->use();
-    mSpriteShader->setValue(PROJECTION, mProjection);
-    mSpriteShader->setValue(MODEL, model);
-    mSpriteShader->setValue(SPRITE_COLOR, color);
-    mSpriteShader->setValue(IS_MONO, isMono ? 1 : 0);
+    mSpriteShader->setValue(mSpriteModel, model);
+    mSpriteShader->setValue(mSpriteColor, color);
+    mSpriteShader->setValue(mSpriteIsMono, isMono ? 1 : 0);
+    mSpriteShader->setValue(mSpriteIsDistance, 0);
 
-    mGl.glActiveTexture(GL_TEXTURE0);
     texture.bind();
 
-    mGl.glBindVertexArray(mVao);
+    mState.bindVertexArray(mQuadVao);
+    mState.countDraw();
     mGl.glDrawArrays(GL_TRIANGLES, 0, 6);
-
-    mGl.glBindBuffer(GL_ARRAY_BUFFER, 0);
-    mGl.glBindVertexArray(0);
 }
 
 void Renderer::drawText(const QString& text, int size, const glm::vec2& position, const glm::vec4& color) {
-    assert(FT_Set_Pixel_Sizes(mFtFace, 0, size) == 0);
-
-    int maxHeight = 0;
-    for (auto i : text) {
-        assert(FT_Load_Char(mFtFace, i.unicode(), FT_LOAD_RENDER) == 0);
-        const int height = static_cast<int>(mFtFace->glyph->bitmap.rows);
-        if (height > maxHeight)
-            maxHeight = height;
+    ProfileScope scope(mProfiler, ProfilePhase::DRAW_TEXT);
+    const auto& run = mTextLayout->run(text);
+    const float scale = static_cast<float>(size) / static_cast<float>(GlyphAtlas::BASE_SIZE);
+    const float spread = static_cast<float>(GlyphAtlas::SPREAD);
+
+    QVector<QVector<float>> pageVertices(mGlyphAtlas->pages());
+
+    float pen = 0.0f;
+    for (const auto& i : run.glyphs) {
+        const auto& glyph = mGlyphAtlas->glyph(i.index);
+        const float x = pen + i.offset.x, y = i.offset.y;
+        pen += i.advance;
+
+        if (glyph.size.x == 0 || glyph.size.y == 0) continue;
+
+        if (pageVertices.size() < mGlyphAtlas->pages())
+            pageVertices.resize(mGlyphAtlas->pages());
+
+        const float x0 = position.x + (x + static_cast<float>(glyph.bearing.x) - spread) * scale;
+        const float y0 = position.y + (y + run.size.y - static_cast<float>(glyph.bearing.y) - spread) * scale;
+        const float x1 = x0 + (static_cast<float>(glyph.size.x) + 2.0f * spread) * scale;
+        const float y1 = y0 + (static_cast<float>(glyph.size.y) + 2.0f * spread) * scale;
+
+        pageVertices[glyph.page].append({
+            x0, y1, glyph.uvMin.x, glyph.uvMax.y,
+            x1, y0, glyph.uvMax.x, glyph.uvMin.y,
+            x0, y0, glyph.uvMin.x, glyph.uvMin.y,
+
+            x0, y1, glyph.uvMin.x, glyph.uvMax.y,
+            x1, y1, glyph.uvMax.x, glyph.uvMax.y,
+            x1, y0, glyph.uvMax.x, glyph.uvMin.y
+        });
+    }
+
+    mSpriteShader->use();
+    mSpriteShader->setValue(mSpriteModel, glm::mat4(1.0f));
+    mSpriteShader->setValue(mSpriteColor, color);
+    mSpriteShader->setValue(mSpriteIsMono, 1);
+    mSpriteShader->setValue(mSpriteIsDistance, 1);
+
+    mState.bindVertexArray(mTextVao);
+    mState.bindBuffer(GL_ARRAY_BUFFER, mTextVbo);
+
+    for (int page = 0; page < pageVertices.size(); page++) {
+        const auto& vertices = pageVertices[page];
+        if (vertices.isEmpty()) continue;
+
+        mState.countBufferData(static_cast<long>(vertices.size() * sizeof(float)));
+        mGl.glBufferData(GL_ARRAY_BUFFER, static_cast<long>(vertices.size() * sizeof(float)), vertices.constData(), GL_DYNAMIC_DRAW);
+        mGlyphAtlas->page(page).bind();
+        mState.countDraw();
+        mGl.glDrawArrays(GL_TRIANGLES, 0, static_cast<int>(vertices.size() / 4));
     }
+}
 
-    int offset = 0;
-    for (auto i : text) {
-        assert(FT_Load_Char(mFtFace, i.unicode(), FT_LOAD_RENDER) == 0);
+QSize Renderer::textMetrics(const QString& text, int size) {
+    const auto& run = mTextLayout->run(text);
+    const float scale = static_cast<float>(size) / static_cast<float>(GlyphAtlas::BASE_SIZE);
+    return {static_cast<int>(glm::ceil(run.size.x * scale)), static_cast<int>(glm::ceil(run.size.y * scale))};
+}
 
-        const auto xSize = glm::ivec2(mFtFace->glyph->bitmap.width, mFtFace->glyph->bitmap.rows);
-        const auto bearing = glm::ivec2(mFtFace->glyph->bitmap_left, mFtFace->glyph->bitmap_top);
-        const auto advance = static_cast<int>(mFtFace->glyph->advance.x);
+void Renderer::drawStroke(const QVector<glm::vec2>& points, float width, const glm::vec4& color) {
+    ProfileScope scope(mProfiler, ProfilePhase::DRAW_STROKE);
+    const auto vertices = strokeVertices(points);
+    if (vertices.isEmpty()) return;
 
-        Texture texture(mGl, xSize[0], xSize[1], mFtFace->glyph->bitmap.buffer, GL_RED);
-        drawTexture(texture, glm::vec2(
-            position.x + static_cast<float>(bearing.x) + static_cast<float>(offset),
-            position.y - static_cast<float>(bearing.y) + static_cast<float>(maxHeight)
-        ), xSize, 0.0f, color, true);
+    mState.bindVertexArray(mShapeVao);
+    mState.bindBuffer(GL_ARRAY_BUFFER, mShapeVbo);
+    mState.countBufferData(static_cast<long>(vertices.size() * sizeof(float)));
+    mGl.glBufferData(GL_ARRAY_BUFFER, static_cast<long>(vertices.size() * sizeof(float)), vertices.constData(), GL_DYNAMIC_DRAW);
 
-        offset += advance >> 6;
-    }
+    mStrokeShader->use();
+    mStrokeShader->setValue(mStrokeWidth, width);
+    mStrokeShader->setValue(mStrokeColor, color);
+
+    mState.countDraw();
+    mGl.glDrawArrays(GL_LINE_STRIP_ADJACENCY, 0, static_cast<int>(vertices.size() / 2));
 }
 
-QSize Renderer::textMetrics(const QString& text, int size) {
-    assert(FT_Set_Pixel_Sizes(mFtFace, 0, size) == 0);
+void Renderer::drawStroke(Mesh& mesh, float width, const glm::vec4& color) {
+    assert(mesh.primitive() == GL_LINE_STRIP_ADJACENCY);
+    ProfileScope scope(mProfiler, ProfilePhase::DRAW_STROKE);
+
+    mStrokeShader->use();
+    mStrokeShader->setValue(mStrokeWidth, width);
+    mStrokeShader->setValue(mStrokeColor, color);
 
-    int width = 0, height = 0;
+    mesh.draw();
+}
 
-    for (auto i : text) {
-        assert(FT_Load_Char(mFtFace, i.unicode(), FT_LOAD_RENDER) == 0);
-        width += static_cast<int>(mFtFace->glyph->advance.x) >> 6;
+Mesh* Renderer::makeStrokeMesh(const QVector<glm::vec2>& points) {
+    return new Mesh(mState, strokeVertices(points), GL_LINE_STRIP_ADJACENCY);
+}
 
-        const auto xHeight = static_cast<int>(mFtFace->glyph->bitmap.rows);
-        if (height < xHeight)
-            height = xHeight;
-    }
+Mesh* Renderer::makeLineMesh(const glm::vec2& positionStart, const glm::vec2& positionEnd, float lineWidth) {
+    QVector<float> vertices;
+    addQuad(vertices, positionStart, positionEnd, lineWidth);
+    return new Mesh(mState, vertices);
+}
+
+void Renderer::drawMesh(Mesh& mesh, const glm::vec4& color) {
+    ProfileScope scope(mProfiler, ProfilePhase::DRAW_SHAPE);
+    mShapeShader->use();
+    mShapeShader->setValue(mShapeColor, color);
 
-    return {width, height};
+    mesh.draw();
 }
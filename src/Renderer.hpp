@@ -21,6 +21,11 @@
 #include "defs.hpp"
 #include "Texture.hpp"
 #include "CompoundShader.hpp"
+#include "Mesh.hpp"
+#include "GlyphAtlas.hpp"
+#include "TextLayout.hpp"
+#include "GlState.hpp"
+#include "GpuProfiler.hpp"
 #include <QOpenGLFunctions_3_3_Core>
 #include <glm/glm.hpp>
 #include <freetype2/ft2build.h>
@@ -29,11 +34,24 @@
 class Renderer final {
 private:
     QOpenGLFunctions_3_3_Core& mGl;
-    CompoundShader* mShapeShader, * mSpriteShader;
-    unsigned mVbo, mEbo, mVao;
-    glm::mat4 mProjection;
+    GlState mState;
+    GpuProfiler mProfiler;
+    CompoundShader* mShapeShader, * mSpriteShader, * mStrokeShader;
+    unsigned mShapeVbo, mShapeVao;
+    unsigned mQuadVbo, mQuadVao;
+    unsigned mTextVbo, mTextVao;
+    unsigned mProjectionUbo;
+    Uniform<glm::vec4> mShapeColor;
+    Uniform<glm::mat4> mSpriteModel;
+    Uniform<glm::vec4> mSpriteColor;
+    Uniform<int> mSpriteIsMono;
+    Uniform<int> mSpriteIsDistance;
+    Uniform<float> mStrokeWidth;
+    Uniform<glm::vec4> mStrokeColor;
     FT_Library mFtLib;
     FT_Face mFtFace;
+    GlyphAtlas* mGlyphAtlas;
+    TextLayout* mTextLayout;
 public:
     explicit Renderer(QOpenGLFunctions_3_3_Core& gl);
     ~Renderer();
@@ -41,13 +59,20 @@ public:
     DISABLE_COPY(Renderer)
     DISABLE_MOVE(Renderer)
 
+    GlState& state();
+    GpuProfiler& profiler();
     void setProjection(const glm::mat4& projection);
 
     void drawPoint(const glm::vec2& position, float pointSize, const glm::vec4& color);
     void drawPoints(int count, const QVector<float>& vertices, float pointSize, const glm::vec4& color, int drawMode);
     void drawLine(const glm::vec2& positionStart, const glm::vec2& positionEnd, float lineWidth, const glm::vec4& color);
-    void drawHollowCircle(const glm::vec2& positionCenter, int radius, const glm::vec4& color);
+    void drawStroke(const QVector<glm::vec2>& points, float width, const glm::vec4& color);
+    void drawStroke(Mesh& mesh, float width, const glm::vec4& color);
     void drawTexture(Texture& texture, const glm::vec2& position, const glm::vec2& size, float rotation, const glm::vec4& color, bool isMono = false);
     void drawText(const QString& text, int size, const glm::vec2& position, const glm::vec4& color);
     QSize textMetrics(const QString& text, int size);
+
+    Mesh* makeStrokeMesh(const QVector<glm::vec2>& points);
+    Mesh* makeLineMesh(const glm::vec2& positionStart, const glm::vec2& positionEnd, float lineWidth);
+    void drawMesh(Mesh& mesh, const glm::vec4& color);
 };
@@ -0,0 +1,124 @@
+/*
+ * Jaoned - an OpenGL & QT based drawing board
+ * Copyright (C) 2024 Vadim Nikolaev (https://github.com/vadniks).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "SpatialIndex.hpp"
+#include <algorithm>
+
+SpatialIndex::SpatialIndex() : mNodes(), mRoot(-1), mNodeOfId() {
+    clear();
+}
+
+void SpatialIndex::insert(int id, const Bounds& bounds) {
+    assert(!mNodeOfId.contains(id));
+
+    const auto center = (bounds.min + bounds.max) * 0.5f;
+    const auto halfExtent = (bounds.max - bounds.min) * 0.5f;
+
+    while (!fits(mRoot, center, halfExtent))
+        growTowards(center);
+
+    int node = mRoot;
+    for (int depth = 0; depth < MAX_DEPTH; depth++) {
+        const float childHalfSize = mNodes[node].halfSize * 0.5f;
+        if (glm::max(halfExtent.x, halfExtent.y) > childHalfSize) break;
+
+        const int quadrant = (center.x >= mNodes[node].center.x ? 1 : 0) | (center.y >= mNodes[node].center.y ? 2 : 0);
+        if (mNodes[node].children[quadrant] < 0) {
+            const glm::vec2 childCenter = mNodes[node].center + glm::vec2(quadrant & 1 ? childHalfSize : -childHalfSize, quadrant & 2 ? childHalfSize : -childHalfSize);
+            const int child = makeNode(childCenter, childHalfSize);
+            mNodes[node].children[quadrant] = child;
+        }
+
+        node = mNodes[node].children[quadrant];
+    }
+
+    mNodes[node].entries.push_back({id, bounds});
+    mNodeOfId.insert(id, node);
+}
+
+void SpatialIndex::remove(int id) {
+    const int node = mNodeOfId.take(id);
+    auto& entries = mNodes[node].entries;
+
+    // elements are usually removed in reverse insertion order, so the entry sits near the end
+    for (auto i = entries.size() - 1; i >= 0; i--) {
+        if (entries[i].id != id) continue;
+        entries.remove(i);
+        return;
+    }
+
+    assert(false);
+}
+
+void SpatialIndex::clear() {
+    mNodes.clear();
+    mNodeOfId.clear();
+    mRoot = makeNode(glm::vec2(0.0f), INITIAL_HALF_SIZE);
+}
+
+QVector<int> SpatialIndex::query(const Bounds& area) const {
+    QVector<int> ids;
+    query(mRoot, area, ids);
+    std::sort(ids.begin(), ids.end());
+    return ids;
+}
+
+int SpatialIndex::size() const {
+    return static_cast<int>(mNodeOfId.size());
+}
+
+int SpatialIndex::makeNode(const glm::vec2& center, float halfSize) {
+    mNodes.push_back({center, halfSize, {-1, -1, -1, -1}, {}});
+    return static_cast<int>(mNodes.size()) - 1;
+}
+
+bool SpatialIndex::fits(int node, const glm::vec2& center, const glm::vec2& halfExtent) const {
+    const auto& xNode = mNodes[node];
+    const auto offset = glm::abs(center - xNode.center);
+
+    return offset.x <= xNode.halfSize && offset.y <= xNode.halfSize && glm::max(halfExtent.x, halfExtent.y) <= xNode.halfSize;
+}
+
+// the old root becomes the quadrant of the new, twice as large, root that lies away from the point
+void SpatialIndex::growTowards(const glm::vec2& point) {
+    const auto oldCenter = mNodes[mRoot].center;
+    const float halfSize = mNodes[mRoot].halfSize;
+
+    const glm::vec2 direction(point.x >= oldCenter.x ? 1.0f : -1.0f, point.y >= oldCenter.y ? 1.0f : -1.0f);
+    const int newRoot = makeNode(oldCenter + direction * halfSize, halfSize * 2.0f);
+
+    const int quadrant = (direction.x < 0.0f ? 1 : 0) | (direction.y < 0.0f ? 2 : 0);
+    mNodes[newRoot].children[quadrant] = mRoot;
+    mRoot = newRoot;
+}
+
+void SpatialIndex::query(int node, const Bounds& area, QVector<int>& ids) const {
+    const auto& xNode = mNodes[node];
+
+    // loose bounds - entries may stick out of the node by up to half of its size on every side
+    const Bounds loose{xNode.center - glm::vec2(xNode.halfSize * 2.0f), xNode.center + glm::vec2(xNode.halfSize * 2.0f)};
+    if (!loose.intersects(area)) return;
+
+    for (const auto& i : xNode.entries)
+        if (i.bounds.intersects(area))
+            ids.push_back(i.id);
+
+    for (int i : xNode.children)
+        if (i >= 0)
+            query(i, area, ids);
+}
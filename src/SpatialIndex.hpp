@@ -0,0 +1,64 @@
+/*
+ * Jaoned - an OpenGL & QT based drawing board
+ * Copyright (C) 2024 Vadim Nikolaev (https://github.com/vadniks).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "defs.hpp"
+#include "Bounds.hpp"
+#include <QVector>
+#include <QHash>
+
+// Loose quadtree over element ids, the root grows to fit whatever is inserted.
+// Ids are draw order positions, queries return them ascending so the order is preserved
+class SpatialIndex final {
+private:
+    struct Entry {
+        int id;
+        Bounds bounds;
+    };
+
+    struct Node {
+        glm::vec2 center;
+        float halfSize;
+        int children[4];
+        QVector<Entry> entries;
+    };
+
+    QVector<Node> mNodes;
+    int mRoot;
+    QHash<int, int> mNodeOfId;
+public:
+    static inline float INITIAL_HALF_SIZE = 1024.0f;
+    static inline int MAX_DEPTH = 16;
+public:
+    SpatialIndex();
+
+    DISABLE_COPY(SpatialIndex)
+    DISABLE_MOVE(SpatialIndex)
+
+    void insert(int id, const Bounds& bounds);
+    void remove(int id);
+    void clear();
+    QVector<int> query(const Bounds& area) const;
+    int size() const;
+private:
+    int makeNode(const glm::vec2& center, float halfSize);
+    bool fits(int node, const glm::vec2& center, const glm::vec2& halfExtent) const;
+    void growTowards(const glm::vec2& point);
+    void query(int node, const Bounds& area, QVector<int>& ids) const;
+};
@@ -0,0 +1,38 @@
+/*
+ * Jaoned - an OpenGL & QT based drawing board
+ * Copyright (C) 2024 Vadim Nikolaev (https://github.com/vadniks).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "StatsServer.hpp"
+#include <QLocalSocket>
+#include <QDebug>
+
+StatsServer::StatsServer(const QString& name, const std::function<QByteArray ()>& snapshot) : mServer(), mSnapshot(snapshot) {
+    connect(&mServer, &QLocalServer::newConnection, this, &StatsServer::connected);
+
+    // a crashed run may have left its socket file behind
+    QLocalServer::removeServer(name);
+    if (!mServer.listen(name))
+        qDebug() << "stats: unable to listen on" << name << mServer.errorString();
+}
+
+void StatsServer::connected() {
+    while (auto* socket = mServer.nextPendingConnection()) {
+        connect(socket, &QLocalSocket::disconnected, socket, &QObject::deleteLater);
+        socket->write(mSnapshot());
+        socket->disconnectFromServer();
+    }
+}
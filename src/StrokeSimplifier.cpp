@@ -0,0 +1,72 @@
+/*
+ * Jaoned - an OpenGL & QT based drawing board
+ * Copyright (C) 2024 Vadim Nikolaev (https://github.com/vadniks).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "StrokeSimplifier.hpp"
+
+StrokeSimplifier::StrokeSimplifier(float tolerance) : mTolerance(tolerance), mAnchor(0), mPending(), mInputCount(0) {}
+
+static float segmentDistance(const glm::vec2& point, const glm::vec2& start, const glm::vec2& end) {
+    const auto direction = end - start;
+    const auto lengthSquared = glm::dot(direction, direction);
+    if (lengthSquared == 0.0f) return glm::distance(point, start);
+
+    const auto t = glm::clamp(glm::dot(point - start, direction) / lengthSquared, 0.0f, 1.0f);
+    return glm::distance(point, start + direction * t);
+}
+
+bool StrokeSimplifier::fits(const glm::vec2& start, const glm::vec2& end) const {
+    for (const auto& i : mPending)
+        if (segmentDistance(i, start, end) > mTolerance) return false;
+    return true;
+}
+
+void StrokeSimplifier::add(QVector<glm::vec2>& points, const glm::vec2& point) {
+    mInputCount++;
+
+    if (points.isEmpty()) {
+        points.push_back(point);
+        mAnchor = 0;
+        mPending.clear();
+        return;
+    }
+
+    const auto& anchor = points[mAnchor];
+
+    if (points.size() == mAnchor + 1) {
+        if (glm::distance(anchor, point) <= mTolerance) return;
+
+        points.push_back(point);
+        mPending.push_back(point);
+        return;
+    }
+
+    if (mPending.size() < MAX_PENDING && fits(anchor, point)) {
+        points.last() = point;
+        mPending.push_back(point);
+        return;
+    }
+
+    mAnchor = static_cast<int>(points.size()) - 1;
+    points.push_back(point);
+    mPending.clear();
+    mPending.push_back(point);
+}
+
+int StrokeSimplifier::inputCount() const {
+    return mInputCount;
+}
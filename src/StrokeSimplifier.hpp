@@ -0,0 +1,45 @@
+/*
+ * Jaoned - an OpenGL & QT based drawing board
+ * Copyright (C) 2024 Vadim Nikolaev (https://github.com/vadniks).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "defs.hpp"
+#include <QVector>
+#include <glm/glm.hpp>
+
+// Online Ramer–Douglas–Peucker: the last stored point stays tentative and slides along with the cursor
+// for as long as every point captured since the previous kept one stays within tolerance of the segment
+class StrokeSimplifier final {
+private:
+    float mTolerance;
+    int mAnchor;
+    QVector<glm::vec2> mPending;
+    int mInputCount;
+public:
+    static inline int MAX_PENDING = 64;
+public:
+    explicit StrokeSimplifier(float tolerance);
+
+    DISABLE_COPY(StrokeSimplifier)
+    DISABLE_MOVE(StrokeSimplifier)
+
+    void add(QVector<glm::vec2>& points, const glm::vec2& point);
+    int inputCount() const;
+private:
+    bool fits(const glm::vec2& start, const glm::vec2& end) const;
+};
@@ -0,0 +1,100 @@
+/*
+ * Jaoned - an OpenGL & QT based drawing board
+ * Copyright (C) 2024 Vadim Nikolaev (https://github.com/vadniks).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "TextLayout.hpp"
+#include <harfbuzz/hb-ft.h>
+
+TextLayout::TextLayout(GlyphAtlas& atlas, FT_Face face) :
+    mAtlas(atlas),
+    mFont(hb_ft_font_create_referenced(face)),
+    mBuffer(hb_buffer_create()),
+    mRuns()
+{
+    assert(hb_buffer_allocation_successful(mBuffer));
+}
+
+TextLayout::~TextLayout() {
+    hb_buffer_destroy(mBuffer);
+    hb_font_destroy(mFont);
+}
+
+const TextRun& TextLayout::run(const QString& text) {
+    auto iterator = mRuns.constFind(text);
+    if (iterator != mRuns.constEnd()) return iterator.value();
+
+    if (mRuns.size() >= MAX_RUNS)
+        mRuns.clear();
+
+    return mRuns.insert(text, shape(text)).value();
+}
+
+TextRun TextLayout::shape(const QString& text) {
+    TextRun run{{}, glm::vec2(0.0f)};
+    int from = 0;
+
+    // typing appends a character at a time, so the previous keystroke's run is usually cached
+    if (text.size() > 1) {
+        auto prefix = mRuns.find(text.left(text.size() - 1));
+
+        if (prefix != mRuns.end()) {
+            const auto& glyphs = prefix.value().glyphs;
+
+            int cut = static_cast<int>(glyphs.size()) - 1;
+            while (cut > 0 && (glyphs[cut].unsafeToBreak || glyphs[cut].cluster <= glyphs[cut - 1].cluster))
+                cut--;
+
+            if (cut > 0) {
+                run.glyphs = glyphs.mid(0, cut);
+                from = glyphs[cut].cluster;
+            }
+
+            // the prefix is most likely an intermediate state nobody draws again
+            mRuns.erase(prefix);
+        }
+    }
+
+    shapeInto(run, text, from);
+
+    for (const auto& i : run.glyphs) {
+        run.size.x += i.advance;
+        run.size.y = glm::max(run.size.y, static_cast<float>(mAtlas.glyph(i.index).size.y));
+    }
+
+    return run;
+}
+
+void TextLayout::shapeInto(TextRun& run, const QString& text, int from) {
+    hb_buffer_clear_contents(mBuffer);
+    hb_buffer_add_utf16(mBuffer, reinterpret_cast<const uint16_t*>(text.utf16()), static_cast<int>(text.size()), static_cast<unsigned>(from), static_cast<int>(text.size()) - from);
+    hb_buffer_guess_segment_properties(mBuffer);
+    hb_shape(mFont, mBuffer, nullptr, 0);
+
+    unsigned count = 0;
+    const auto* infos = hb_buffer_get_glyph_infos(mBuffer, &count);
+    const auto* positions = hb_buffer_get_glyph_positions(mBuffer, &count);
+
+    run.glyphs.reserve(run.glyphs.size() + count);
+    for (unsigned i = 0; i < count; i++)
+        run.glyphs.push_back({
+            infos[i].codepoint,
+            static_cast<int>(infos[i].cluster),
+            (hb_glyph_info_get_glyph_flags(&infos[i]) & HB_GLYPH_FLAG_UNSAFE_TO_BREAK) != 0,
+            glm::vec2(static_cast<float>(positions[i].x_offset), -static_cast<float>(positions[i].y_offset)) / 64.0f,
+            static_cast<float>(positions[i].x_advance) / 64.0f
+        });
+}
@@ -0,0 +1,65 @@
+/*
+ * Jaoned - an OpenGL & QT based drawing board
+ * Copyright (C) 2024 Vadim Nikolaev (https://github.com/vadniks).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "defs.hpp"
+#include "GlyphAtlas.hpp"
+#include <QVector>
+#include <QHash>
+#include <QString>
+#include <glm/glm.hpp>
+#include <harfbuzz/hb.h>
+
+struct PlacedGlyph {
+    unsigned index;
+    int cluster; // utf-16 offset of the first character this glyph came from
+    bool unsafeToBreak; // the run can't be cut right before this glyph
+    glm::vec2 offset;
+    float advance;
+};
+
+// shaped at GlyphAtlas::BASE_SIZE and scaled when drawn, size is the pen advance and the tallest ink box
+struct TextRun {
+    QVector<PlacedGlyph> glyphs;
+    glm::vec2 size;
+};
+
+// Shapes strings with HarfBuzz over the atlas face and caches the runs by text, glyphs being distance fields
+// the same run serves every size. A string that extends a cached one by a character reuses its glyphs
+// up to the last safe break and only reshapes the tail
+class TextLayout final {
+private:
+    GlyphAtlas& mAtlas;
+    hb_font_t* mFont;
+    hb_buffer_t* mBuffer;
+    QHash<QString, TextRun> mRuns;
+public:
+    static inline int MAX_RUNS = 4096;
+public:
+    TextLayout(GlyphAtlas& atlas, FT_Face face);
+    ~TextLayout();
+
+    DISABLE_COPY(TextLayout)
+    DISABLE_MOVE(TextLayout)
+
+    const TextRun& run(const QString& text);
+private:
+    TextRun shape(const QString& text);
+    void shapeInto(TextRun& run, const QString& text, int from);
+};
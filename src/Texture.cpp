@@ -19,10 +19,15 @@
 #include "Texture.hpp"
 #include <QSize>
 
-Texture::Texture(QOpenGLFunctions_3_3_Core& gl, int width, int height, const uchar* data, int format) : mGl(gl), mId(0), mWidth(width), mHeight(height) {
+static qint64 pixelBytes(int format, int width, int height) {
+    const int channels = format == GL_RED ? 1 : format == GL_RGB ? 3 : 4;
+    return static_cast<qint64>(width) * height * channels;
+}
+
+Texture::Texture(GlState& state, int width, int height, const uchar* data, int format) : mState(state), mGl(state.gl()), mId(0), mWidth(width), mHeight(height), mFormat(format) {
     assert(format == GL_RED || format == GL_RGB || format == GL_RGBA);
     mGl.glGenTextures(1, &mId);
-    mGl.glBindTexture(GL_TEXTURE_2D, mId);
+    mState.bindTexture(0, mId);
     if (format == GL_RED) mGl.glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
     mGl.glTexImage2D(
         GL_TEXTURE_2D,
@@ -35,19 +40,38 @@ Texture::Texture(QOpenGLFunctions_3_3_Core& gl, int width, int height, const uch
         GL_UNSIGNED_BYTE,
         data
     );
+    if (data != nullptr) mState.countTextureUpload(pixelBytes(format, width, height));
     mGl.glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
     mGl.glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
     mGl.glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
     mGl.glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    mGl.glBindTexture(GL_TEXTURE_2D, 0);
 }
 
 Texture::~Texture() {
+    mState.forgetTexture(mId);
     mGl.glDeleteTextures(1, &mId);
 }
 
 void Texture::bind() {
-    mGl.glBindTexture(GL_TEXTURE_2D, mId);
+    mState.bindTexture(0, mId);
+}
+
+void Texture::update(int x, int y, int width, int height, const uchar* data) {
+    assert(x >= 0 && y >= 0 && x + width <= mWidth && y + height <= mHeight);
+    mState.bindTexture(0, mId);
+    if (mFormat == GL_RED) mGl.glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    mGl.glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, width, height, mFormat, GL_UNSIGNED_BYTE, data);
+    mState.countTextureUpload(pixelBytes(mFormat, width, height));
+}
+
+void Texture::generateMipmaps() {
+    mState.bindTexture(0, mId);
+    mGl.glGenerateMipmap(GL_TEXTURE_2D);
+    mGl.glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+}
+
+unsigned Texture::id() const {
+    return mId;
 }
 
 QSize Texture::size() {
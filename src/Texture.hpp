@@ -19,20 +19,26 @@
 #pragma once
 
 #include "defs.hpp"
+#include "GlState.hpp"
 #include <QOpenGLFunctions_3_3_Core>
 
 class Texture final {
 private:
+    GlState& mState;
     QOpenGLFunctions_3_3_Core& mGl;
     unsigned mId;
     int mWidth, mHeight;
+    int mFormat;
 public:
-    Texture(QOpenGLFunctions_3_3_Core& gl, int width, int height, const uchar* data, int format = GL_RGBA);
+    Texture(GlState& state, int width, int height, const uchar* data, int format = GL_RGBA);
     ~Texture();
 
     DISABLE_COPY(Texture)
     DISABLE_MOVE(Texture)
 
     void bind();
+    unsigned id() const;
+    void update(int x, int y, int width, int height, const uchar* data);
+    void generateMipmaps();
     QSize size();
 };
@@ -0,0 +1,205 @@
+/*
+ * Jaoned - an OpenGL & QT based drawing board
+ * Copyright (C) 2024 Vadim Nikolaev (https://github.com/vadniks).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "TileCache.hpp"
+#include <algorithm>
+#include <glm/ext/matrix_clip_space.hpp>
+
+static quint64 tileKey(int x, int y) {
+    return (static_cast<quint64>(static_cast<quint32>(x)) << 32) | static_cast<quint64>(static_cast<quint32>(y));
+}
+
+static int tileIndex(float coordinate) {
+    return static_cast<int>(floorf(coordinate / static_cast<float>(TileCache::TILE_SIZE)));
+}
+
+static int tileTexels(float scale) {
+    return static_cast<int>(ceilf(static_cast<float>(TileCache::TILE_SIZE) * scale));
+}
+
+TileCache::TileCache(GlState& state, int samples, float scale) :
+    mState(state),
+    mGl(state.gl()),
+    mSamples(samples),
+    mScale(scale),
+    mTexels(tileTexels(scale)),
+    mMultisampleFramebuffer(0),
+    mMultisampleRenderbuffer(0),
+    mTiles(),
+    mFrame(0)
+{
+    if (mSamples <= 0) return;
+
+    mGl.glGenRenderbuffers(1, &mMultisampleRenderbuffer);
+    mGl.glGenFramebuffers(1, &mMultisampleFramebuffer);
+    allocateMultisample();
+}
+
+TileCache::~TileCache() {
+    evict(0);
+
+    if (mSamples <= 0) return;
+    mGl.glDeleteFramebuffers(1, &mMultisampleFramebuffer);
+    mGl.glDeleteRenderbuffers(1, &mMultisampleRenderbuffer);
+}
+
+void TileCache::invalidate(const Bounds& bounds) {
+    for (int x = tileIndex(bounds.min.x); x <= tileIndex(bounds.max.x); x++) {
+        for (int y = tileIndex(bounds.min.y); y <= tileIndex(bounds.max.y); y++) {
+            auto iterator = mTiles.find(tileKey(x, y));
+            if (iterator != mTiles.end())
+                iterator->valid = false;
+        }
+    }
+}
+
+void TileCache::invalidateAll() {
+    for (auto& i : mTiles)
+        i.valid = false;
+}
+
+void TileCache::setScale(float scale) {
+    if (scale == mScale) return;
+
+    // tiles hold device pixels, so those rasterized for another screen are of the wrong size
+    mScale = scale;
+    mTexels = tileTexels(scale);
+    evict(0);
+
+    if (mSamples > 0)
+        allocateMultisample();
+}
+
+void TileCache::draw(
+    Renderer& renderer,
+    const Bounds& viewport,
+    const glm::mat4& projection,
+    unsigned targetFramebuffer,
+    const glm::vec4& background,
+    const std::function<void (const Bounds&)>& painter
+) {
+    mFrame++;
+
+    const int x0 = tileIndex(viewport.min.x), x1 = tileIndex(viewport.max.x);
+    const int y0 = tileIndex(viewport.min.y), y1 = tileIndex(viewport.max.y);
+
+    int restoredViewport[4];
+    mGl.glGetIntegerv(GL_VIEWPORT, restoredViewport);
+
+    bool rendered = false;
+    for (int x = x0; x <= x1; x++) {
+        for (int y = y0; y <= y1; y++) {
+            auto& xTile = tile(x, y);
+            xTile.lastUsed = mFrame;
+            if (xTile.valid) continue;
+
+            render(xTile, x, y, renderer, background, painter);
+            rendered = true;
+        }
+    }
+
+    if (rendered) {
+        mGl.glBindFramebuffer(GL_FRAMEBUFFER, targetFramebuffer);
+        mGl.glViewport(restoredViewport[0], restoredViewport[1], restoredViewport[2], restoredViewport[3]);
+        renderer.setProjection(projection);
+    }
+
+    mState.setBlending(false);
+
+    const auto size = glm::vec2(static_cast<float>(TILE_SIZE));
+    for (int x = x0; x <= x1; x++)
+        for (int y = y0; y <= y1; y++)
+            renderer.drawTexture(*(tile(x, y).texture), glm::vec2(static_cast<float>(x), static_cast<float>(y)) * size, size, 0.0f, glm::vec4(1.0f));
+
+    // memory follows the viewport, so a board scrolled over for a while doesn't pile up tiles
+    evict((x1 - x0 + 1 + 2 * TILE_MARGIN) * (y1 - y0 + 1 + 2 * TILE_MARGIN));
+}
+
+int TileCache::tiles() const {
+    return static_cast<int>(mTiles.size());
+}
+
+TileCache::Tile& TileCache::tile(int x, int y) {
+    const auto key = tileKey(x, y);
+
+    auto iterator = mTiles.find(key);
+    if (iterator != mTiles.end())
+        return iterator.value();
+
+    Tile xTile{new Texture(mState, mTexels, mTexels, nullptr), 0, false, mFrame};
+
+    mGl.glGenFramebuffers(1, &xTile.framebuffer);
+    mGl.glBindFramebuffer(GL_FRAMEBUFFER, xTile.framebuffer);
+    mGl.glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, xTile.texture->id(), 0);
+    assert(mGl.glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE);
+
+    return mTiles.insert(key, xTile).value();
+}
+
+void TileCache::render(Tile& tile, int x, int y, Renderer& renderer, const glm::vec4& background, const std::function<void (const Bounds&)>& painter) {
+    const auto origin = glm::vec2(static_cast<float>(x), static_cast<float>(y)) * static_cast<float>(TILE_SIZE);
+    const Bounds bounds{origin, origin + glm::vec2(static_cast<float>(TILE_SIZE))};
+
+    mGl.glBindFramebuffer(GL_FRAMEBUFFER, mSamples > 0 ? mMultisampleFramebuffer : tile.framebuffer);
+    mGl.glViewport(0, 0, mTexels, mTexels);
+
+    // bottom and top are swapped relative to the screen projection so that texture row 0 holds the tile's top edge
+    renderer.setProjection(glm::ortho(bounds.min.x, bounds.max.x, bounds.min.y, bounds.max.y, -1.0f, 1.0f));
+
+    mGl.glClearColor(background.r, background.g, background.b, background.a);
+    mGl.glClear(GL_COLOR_BUFFER_BIT);
+
+    painter(bounds);
+
+    if (mSamples > 0) {
+        mGl.glBindFramebuffer(GL_READ_FRAMEBUFFER, mMultisampleFramebuffer);
+        mGl.glBindFramebuffer(GL_DRAW_FRAMEBUFFER, tile.framebuffer);
+        mGl.glBlitFramebuffer(0, 0, mTexels, mTexels, 0, 0, mTexels, mTexels, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+    }
+
+    tile.valid = true;
+}
+
+void TileCache::evict(int keep) {
+    if (mTiles.size() <= keep) return;
+
+    QVector<QPair<long, quint64>> candidates;
+    for (auto i = mTiles.constBegin(); i != mTiles.constEnd(); i++)
+        if (i->lastUsed != mFrame || keep == 0)
+            candidates.push_back({i->lastUsed, i.key()});
+
+    std::sort(candidates.begin(), candidates.end());
+
+    for (const auto& i : candidates) {
+        if (mTiles.size() <= keep) break;
+
+        auto xTile = mTiles.take(i.second);
+        mGl.glDeleteFramebuffers(1, &xTile.framebuffer);
+        delete xTile.texture;
+    }
+}
+
+void TileCache::allocateMultisample() {
+    mGl.glBindRenderbuffer(GL_RENDERBUFFER, mMultisampleRenderbuffer);
+    mGl.glRenderbufferStorageMultisample(GL_RENDERBUFFER, mSamples, GL_RGBA8, mTexels, mTexels);
+    mGl.glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+    mGl.glBindFramebuffer(GL_FRAMEBUFFER, mMultisampleFramebuffer);
+    mGl.glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, mMultisampleRenderbuffer);
+    assert(mGl.glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE);
+}
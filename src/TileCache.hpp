@@ -0,0 +1,73 @@
+/*
+ * Jaoned - an OpenGL & QT based drawing board
+ * Copyright (C) 2024 Vadim Nikolaev (https://github.com/vadniks).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "defs.hpp"
+#include "Bounds.hpp"
+#include "Renderer.hpp"
+#include <functional>
+#include <QHash>
+#include <QOpenGLFunctions_3_3_Core>
+
+// Keeps committed board content rasterized into world-space tiles, so a frame only composites the visible ones
+class TileCache final {
+private:
+    struct Tile {
+        Texture* texture;
+        unsigned framebuffer;
+        bool valid;
+        long lastUsed;
+    };
+
+    GlState& mState;
+    QOpenGLFunctions_3_3_Core& mGl;
+    int mSamples;
+    float mScale;
+    int mTexels;
+    unsigned mMultisampleFramebuffer, mMultisampleRenderbuffer;
+    QHash<quint64, Tile> mTiles;
+    long mFrame;
+public:
+    static inline int TILE_SIZE = 512;
+    static inline int TILE_MARGIN = 1; // rings of tiles kept around the visible ones, the rest are evicted
+public:
+    TileCache(GlState& state, int samples, float scale);
+    ~TileCache();
+
+    DISABLE_COPY(TileCache)
+    DISABLE_MOVE(TileCache)
+
+    void invalidate(const Bounds& bounds);
+    void invalidateAll();
+    void setScale(float scale);
+    void draw(
+        Renderer& renderer,
+        const Bounds& viewport,
+        const glm::mat4& projection,
+        unsigned targetFramebuffer,
+        const glm::vec4& background,
+        const std::function<void (const Bounds&)>& painter
+    );
+    int tiles() const;
+private:
+    Tile& tile(int x, int y);
+    void render(Tile& tile, int x, int y, Renderer& renderer, const glm::vec4& background, const std::function<void (const Bounds&)>& painter);
+    void evict(int keep);
+    void allocateMultisample();
+};